@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef BASEINDEX_H
+#define BASEINDEX_H
+
+#include <FileParseEntry.h>
+#include <ImportOptions.h>
+#include <TextFolder.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Index files authors.idx, genres.idx and series.idx are written to
+// collection directory together with base. All numbers are little-endian.
+//
+// "MLIDX" (5 bytes), version (uint8_t, 1)
+// keys number (uint64_t)
+// for every key in ascending byte order:
+//   key size (uint16_t), key (UTF-8)
+//   offsets number (uint64_t), offsets (uint64_t each, ascending)
+//
+// Offset is position in base file of size field of book record, which
+// contains given author, genre or series. Series number is not included in
+// series key.
+//
+// If search keys are requested, search_keys file is written too:
+//
+// "MLSK" (4 bytes), version (uint8_t, 1), transliteration (uint8_t, 0 or 1)
+// three sections (authors, titles, series), every section is:
+//   values number (uint64_t)
+//   for every value in ascending byte order of key, then of value:
+//     key size (uint16_t), key (see TextFolder)
+//     value size (uint16_t), value as it is written in base
+//     offsets number (uint64_t), offsets (uint64_t each, ascending)
+//
+// Key is computed once for every unique value, so search can compare
+// normalized query with keys without normalization of base strings.
+class BaseIndex
+{
+public:
+  BaseIndex(const int &search_keys);
+
+  void
+  addEntry(const FileParseEntry &fpe, const uint64_t &entry_offset);
+
+  bool
+  write(const std::filesystem::path &coll_path);
+
+private:
+  void
+  addValues(std::unordered_map<std::string, std::vector<uint64_t>> &index,
+            const std::string &values, const uint64_t &offset);
+
+  std::string
+  seriesName(const std::string &series);
+
+  bool
+  writeIndex(
+      const std::filesystem::path &index_path,
+      const std::unordered_map<std::string, std::vector<uint64_t>> &index);
+
+  bool
+  writeSearchKeys(const std::filesystem::path &keys_path);
+
+  void
+  addSection(
+      std::fstream &f, std::string &buf, const TextFolder &folder,
+      const std::unordered_map<std::string, std::vector<uint64_t>> &index);
+
+  int search_keys = ImportOptions::NoKeys;
+
+  std::unordered_map<std::string, std::vector<uint64_t>> authors;
+  std::unordered_map<std::string, std::vector<uint64_t>> genres;
+  std::unordered_map<std::string, std::vector<uint64_t>> series;
+  std::unordered_map<std::string, std::vector<uint64_t>> titles;
+};
+
+#endif // BASEINDEX_H
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef BOOKCACHE_H
+#define BOOKCACHE_H
+
+#include <AuxFunc.h>
+#include <FileParseEntry.h>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+#ifndef USE_OPENMP
+#include <mutex>
+#endif
+
+class BookCacheEntry
+{
+public:
+  std::string arch_path;
+  std::string book_path;
+  uint64_t annotation_offset = 0;
+  uint64_t annotation_size = 0;
+  uint64_t cover_offset = 0;
+  uint64_t cover_size = 0;
+  std::string cover_type;
+};
+
+class BookCachePending
+{
+public:
+  BookCacheEntry bce;
+  std::string annotation;
+  std::string cover;
+};
+
+// Annotations and covers of fb2 books are written to book_cache file in
+// collection directory one after another, index is written to
+// book_cache.idx. All numbers are little-endian.
+//
+// "MLBC" (4 bytes), version (uint8_t, 2)
+// entries number (uint64_t)
+// for every entry sorted by archive and book paths:
+//   archive path relative to books directory (uint16_t size, UTF-8)
+//   book path inside archive (uint16_t size, UTF-8)
+//   annotation offset and size in book_cache (uint64_t each)
+//   cover offset and size in book_cache (uint64_t each)
+//   cover content type (uint16_t size, string)
+//
+// Annotation is inner XML of fb2 <annotation> element converted to UTF-8.
+// Cover is thumbnail of image from fb2 <binary> element: images larger than
+// thumbnail_size pixels are downscaled and saved as JPEG (PNG if image has
+// transparency), smaller ones and images, which cannot be decoded, are kept
+// as is. Absent data has zero size.
+//
+// Cache is filled by import threads while archives are processed. Archives
+// are numbered by caller in order of base and their data is written to
+// book_cache in order of numbers, whatever thread finishes first, so
+// book_cache does not depend on number of threads. Data of finished
+// archives waits in memory until all previous archives have been written.
+// Every number must be committed once, even if archive has no data.
+class BookCache
+{
+public:
+  BookCache(const std::shared_ptr<AuxFunc> &af);
+
+  virtual ~BookCache();
+
+  bool
+  open(const std::filesystem::path &coll_path);
+
+  bool
+  addArchive(const std::filesystem::path &arch_path,
+             const FileParseEntry &fpe, const size_t &seq,
+             const std::function<bool()> &canceled);
+
+  // For books already unpacked by caller. Archive and book paths are set by
+  // caller.
+  bool
+  bookData(const std::string &book, BookCachePending &pb);
+
+  void
+  commit(const size_t &seq, std::vector<BookCachePending> &&books);
+
+  bool
+  close(const std::vector<FileParseEntry> &base);
+
+  int thumbnail_size = 320;
+
+private:
+  bool
+  thumbnail(std::string &cover, std::string &cover_type);
+
+  std::string
+  base64Decode(const std::string &str, std::string::size_type beg,
+               std::string::size_type end);
+
+  void
+  append(BookCachePending &pb);
+
+  std::shared_ptr<AuxFunc> af;
+
+  std::filesystem::path coll_path;
+  std::fstream blob;
+  uint64_t blob_size = 0;
+  std::vector<BookCacheEntry> entries;
+
+  std::map<size_t, std::vector<BookCachePending>> pending;
+  size_t next_seq = 0;
+
+#ifndef USE_OPENMP
+  std::mutex blob_mtx;
+#endif
+#ifdef USE_OPENMP
+  omp_lock_t blob_mtx;
+#endif
+};
+
+#endif // BOOKCACHE_H
@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef BOOKMETA_H
+#define BOOKMETA_H
+
+#include <cstdint>
+
+// Parsers separate series number from series name by this character, so
+// series name is known exactly (name can end with number too). Separator is
+// replaced by space, when record is written to base or database.
+const char series_number_separator = '\x1f';
+
+// INP columns, which are not written to base.
+class BookMeta
+{
+public:
+  uint64_t size = 0;
+  uint64_t lib_id = 0;
+};
+
+#endif // BOOKMETA_H
@@ -18,8 +18,24 @@
 
 #include <ArchEntry.h>
 #include <AuxFunc.h>
+#include <BookCache.h>
+#include <BookMeta.h>
+#include <CollectionState.h>
+#include <DuplicateIndex.h>
 #include <FileParseEntry.h>
 #include <Hasher.h>
+#include <ImportOptions.h>
+#include <ImportPlan.h>
+#include <ImportScheduler.h>
+#include <ImportSource.h>
+#include <InpEntry.h>
+#include <InpxCache.h>
+#include <MappedFile.h>
+#include <RateLimiter.h>
+#include <ReadEnginePool.h>
+#include <TraceRecorder.h>
+#include <VerifyReport.h>
+#include <ZipIndex.h>
 #include <functional>
 
 #ifdef USE_OPENMP
@@ -27,8 +43,6 @@
 #endif
 #ifndef USE_OPENMP
 #include <atomic>
-#include <condition_variable>
-#include <mutex>
 #endif
 
 class CollectionProcess
@@ -39,26 +53,126 @@ public:
   virtual ~CollectionProcess();
 
   void
-  collectFiles(const std::filesystem::path &inpx_path,
-               const std::filesystem::path &books_path,
+  collectFiles(const std::vector<ImportSource> &sources,
                const std::string &coll_name);
 
   void
   createBase();
 
+  bool
+  updateBase();
+
+  void
+  verifyBase(const std::string &coll_name, VerifyReport &report);
+
+  void
+  planBase(ImportPlan &plan);
+
   void
   stopAll();
 
+  bool
+  interrupted();
+
+  void
+  setScheduler(const std::shared_ptr<ImportScheduler> &scheduler);
+
+  void
+  setOptions(const ImportOptions &options);
+
+  void
+  setRateLimit(const double &bytes_per_sec);
+
   std::function<void(const double &current_sz, const double &total_sz)>
       signal_progress;
 
 private:
+  bool
+  addSource(const std::filesystem::path &inpx_path,
+            const std::vector<std::filesystem::path> &roots,
+            std::unordered_map<std::string, std::filesystem::path> &orphans);
+
+  void
+  addOrphans(
+      const std::unordered_map<std::string, std::filesystem::path> &archives);
+
+  std::filesystem::path
+  commonPath(const std::vector<ImportSource> &sources);
+
+  // io_done is called when .inp file has been read (before parsing).
+  void
+  parseInp(const InpEntry &ie, FileParseEntry &fpe,
+           std::vector<BookMeta> &meta,
+           const std::function<void()> &io_done = std::function<void()>());
+
+  void
+  parseArchive(const InpEntry &ie, FileParseEntry &fpe,
+               std::vector<BookMeta> &meta);
+
+  bool
+  unpackZipBook(const std::string_view &zip, const ZipIndex &zi,
+                const std::string &name, std::string &book);
+
+  size_t
+  checkBooks(const std::filesystem::path &arch_path, FileParseEntry &fpe,
+             std::vector<BookMeta> &meta);
+
+  size_t
+  checkBooks(const ZipIndex &zi, const std::filesystem::path &arch_path,
+             FileParseEntry &fpe, std::vector<BookMeta> &meta);
+
   void
-  parseInp(const std::filesystem::path &arch_path, const ArchEntry &e,
-           FileParseEntry &fpe);
+  processEntries();
+
+  bool
+  verifyArchive(const size_t &n);
+
+  bool
+  importBase();
+
+  bool
+  writeBase(const std::filesystem::path &coll_path);
+
+  std::string
+  baseEntry(const FileParseEntry &fpe);
+
+  bool
+  readBase(const std::filesystem::path &base_path,
+           std::filesystem::path &base_books_path,
+           std::vector<FileParseEntry> &result,
+           const std::unordered_map<uint64_t, size_t> *series_names
+           = nullptr);
 
   void
-  parseEntry(const std::string &ent, FileParseEntry &fpe);
+  readSeriesNames(const std::filesystem::path &index_path,
+                  std::unordered_map<uint64_t, size_t> &names);
+
+  void
+  probeSpeed(ImportPlan &plan, size_t &hash_len);
+
+  void
+  saveInpxCaches();
+
+  int
+  takeThreads(const int &chunks);
+
+  void
+  startTrace();
+
+  void
+  finishTrace(const std::filesystem::path &coll_path);
+
+  std::filesystem::path
+  collectionPath();
+
+  void
+  removeDuplicates();
+
+  std::string
+  hashArchive(const std::filesystem::path &arch_path);
+
+  void
+  createReadPool();
 
   std::shared_ptr<AuxFunc> af;
   int thr_num = 1;
@@ -69,31 +183,47 @@ private:
   bool cancel = false;
 #endif  
   Hasher *hsh;
+  std::shared_ptr<ImportScheduler> scheduler;
+  ImportOptions options;
+  DuplicateIndex *dup_index = nullptr;
+  BookCache *book_cache = nullptr;
+  RateLimiter *rate_limiter = nullptr;
+  ReadEnginePool *read_pool = nullptr;
+  TraceRecorder *trace = nullptr;
+
+  std::vector<InpEntry> books_entries_list;
 
-  std::vector<ArchEntry> books_entries_list;
+  // Mapped .inpx files, which have .inp files stored without compression.
+  std::unordered_map<std::string, std::shared_ptr<MappedFile>> inpx_maps;
+
+  std::unordered_map<std::string, std::shared_ptr<InpxCache>> inpx_caches;
 
   std::vector<FileParseEntry> base;
-#ifndef USE_OPENMP
-  std::mutex base_mtx;
-#endif
-#ifdef USE_OPENMP
-  omp_lock_t base_mtx;
-#endif
 
-  std::filesystem::path inpx_path;
   std::filesystem::path books_path;
   std::string coll_name;
 
   double total_size = 0.0;
+  size_t unmatched_inp = 0;
+  size_t probe_limit = 67108864;
+  // Memory for archives read by ReadEngine of all threads.
+  uint64_t read_memory = 268435456;
 #ifdef USE_OPENMP
   double parsed_bytes = 0.0;
 #endif
 
+  size_t min_chunk_size = 1048576;
+  size_t max_inp_buffer = 67108864;
+
+#ifndef USE_OPENMP
+  std::atomic<int> active_inp;
+#endif
+#ifdef USE_OPENMP
+  int active_inp = 0;
+#endif
+
 #ifndef USE_OPENMP
   std::atomic<double> parsed_bytes;
-  int run_thr = 0;
-  std::mutex run_thr_mtx;
-  std::condition_variable run_thr_var;
 #endif
 };
 
@@ -18,6 +18,7 @@
 
 #include <AuxFunc.h>
 #include <CollectionProcess.h>
+#include <chrono>
 #include <glibmm-2.68/glibmm/dispatcher.h>
 #include <gtkmm-4.0/gtkmm/label.h>
 #include <gtkmm-4.0/gtkmm/progressbar.h>
@@ -32,19 +33,52 @@ public:
   virtual ~CollectionProcessGui();
 
   void
-  createWindow(const std::filesystem::path &inpx_path,
-               const std::filesystem::path &books_path,
+  createWindow(const std::vector<ImportSource> &sources,
                const std::string &coll_name);
 
+  void
+  createPlanWindow(const std::vector<ImportSource> &sources);
+
+  void
+  createVerifyWindow(const std::string &coll_name, const double &rate_limit);
+
+  void
+  setOptions(const ImportOptions &options);
+
 private:
   void
-  launchProc(const std::filesystem::path &inpx_path,
-             const std::filesystem::path &books_path,
+  progressWindow(const Glib::ustring &title, const Glib::ustring &operation);
+
+  void
+  launchProc(const std::vector<ImportSource> &sources,
              const std::string &coll_name);
 
   void
   completeMessage();
 
+  void
+  launchPlan(const std::vector<ImportSource> &sources);
+
+  void
+  planMessage();
+
+  void
+  launchVerify(const std::string &coll_name);
+
+  void
+  verifyMessage();
+
+  void
+  tableMessage(
+      const std::vector<std::tuple<Glib::ustring, Glib::ustring>> &rows,
+      const Glib::ustring &note);
+
+  Glib::ustring
+  sizeString(const double &sz);
+
+  Glib::ustring
+  timeString(const double &tm);
+
   Gtk::Window *parent_window;
   std::shared_ptr<AuxFunc> af;
   int thr_num;
@@ -55,6 +89,10 @@ private:
 
   bool canceled = false;
 
+  ImportPlan plan;
+  VerifyReport verify_report;
+  std::chrono::time_point<std::chrono::steady_clock> verify_start;
+
   std::atomic<double> parsed_bytes;
   std::atomic<double> total_size;
 
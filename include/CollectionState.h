@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef COLLECTIONSTATE_H
+#define COLLECTIONSTATE_H
+
+#include <InpEntry.h>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ArchiveState
+{
+public:
+  uint64_t arch_size = 0;
+  int64_t arch_mtime = 0;
+  uint32_t inp_crc = 0;
+  uint64_t inp_size = 0;
+  std::string file_hash;
+};
+
+class CollectionState
+{
+public:
+  CollectionState();
+
+  bool
+  read(const std::filesystem::path &state_path);
+
+  bool
+  write(const std::filesystem::path &state_path,
+        const std::filesystem::path &books_path,
+        const std::vector<InpEntry> &entries);
+
+  bool
+  unchangedArchive(const std::string &rel_path, const InpEntry &ie,
+                   std::string &file_hash) const;
+
+  bool
+  unchangedInp(const std::string &rel_path, const InpEntry &ie) const;
+
+  // Path to books directory, which relative paths of archives refer to.
+  std::filesystem::path books_path;
+
+  std::unordered_map<std::string, ArchiveState> archives;
+
+private:
+  static int64_t
+  mtime(const std::filesystem::file_time_type &tm);
+};
+
+#endif // COLLECTIONSTATE_H
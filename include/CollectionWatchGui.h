@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef COLLECTIONWATCHGUI_H
+#define COLLECTIONWATCHGUI_H
+
+#include <AuxFunc.h>
+#include <CollectionProcess.h>
+#include <giomm-2.68/giomm/filemonitor.h>
+#include <glibmm-2.68/glibmm/dispatcher.h>
+#include <gtkmm-4.0/gtkmm/label.h>
+#include <gtkmm-4.0/gtkmm/window.h>
+
+class CollectionWatchGui
+{
+public:
+  CollectionWatchGui(Gtk::Window *parent_window,
+                     const std::shared_ptr<AuxFunc> &af, const int &thr_num);
+
+  virtual ~CollectionWatchGui();
+
+  void
+  createWindow(const std::vector<ImportSource> &sources,
+               const std::string &coll_name, const ImportOptions &options);
+
+private:
+  void
+  startMonitors();
+
+  void
+  fileChanged(const Glib::RefPtr<Gio::File> &file,
+              const Glib::RefPtr<Gio::File> &other_file,
+              Gio::FileMonitor::Event event);
+
+  bool
+  debounceFinished();
+
+  void
+  launchUpdate();
+
+  void
+  updateFinished();
+
+  Gtk::Window *parent_window;
+  std::shared_ptr<AuxFunc> af;
+  int thr_num;
+
+  std::vector<ImportSource> sources;
+  std::string coll_name;
+  ImportOptions options;
+
+  Gtk::Window *main_window = nullptr;
+  Gtk::Label *status = nullptr;
+
+  std::vector<Glib::RefPtr<Gio::FileMonitor>> monitors;
+  sigc::connection debounce;
+  // Update is started after this period of time without changes (ms).
+  unsigned int debounce_interval = 10000;
+
+  CollectionProcess *coll_proc = nullptr;
+  bool changes_pending = false;
+  bool close_pending = false;
+  bool updated = false;
+
+  Glib::Dispatcher *finished_disp = nullptr;
+};
+
+#endif // COLLECTIONWATCHGUI_H
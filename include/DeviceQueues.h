@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef DEVICEQUEUES_H
+#define DEVICEQUEUES_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class DeviceQueue
+{
+public:
+  std::deque<size_t> entries;
+  int active = 0;
+};
+
+// Archives are grouped by disks they are located on (partitions of one disk
+// are one device), every disk has its own queue. Next archive is taken from
+// disk with the smallest number of archives being processed, so all disks
+// are read at the same time. Number of archives processed simultaneously on
+// one disk can be limited.
+class DeviceQueues
+{
+public:
+  DeviceQueues(const int &device_threads);
+
+  void
+  add(const size_t &entry, const std::filesystem::path &arch_path);
+
+  bool
+  next(size_t &entry, size_t &queue, const std::function<bool()> &canceled);
+
+  void
+  release(const size_t &queue);
+
+  size_t
+  devicesNumber();
+
+private:
+  std::string
+  deviceId(const std::filesystem::path &arch_path);
+
+#ifdef __linux
+  std::string
+  diskId(const uint64_t &dev);
+
+  std::unordered_map<uint64_t, std::string> disks;
+#endif
+
+  int device_threads = 0;
+  size_t remaining = 0;
+  std::vector<DeviceQueue> queues;
+  std::unordered_map<std::string, size_t> queue_ids;
+
+  std::mutex mtx;
+  std::condition_variable var;
+};
+
+#endif // DEVICEQUEUES_H
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef DIRSCANNER_H
+#define DIRSCANNER_H
+
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#ifndef USE_OPENMP
+#include <condition_variable>
+#include <mutex>
+#endif
+
+// Recursive enumeration of several directories by several threads. Files
+// are returned by stem. If files with equal stem are found, file from root
+// listed earlier is taken, then file with smaller nesting depth, then file
+// with lexicographically smaller path. Symbolic links to directories are not
+// followed.
+class DirScanner
+{
+public:
+  DirScanner(const int &thr_num);
+
+  bool
+  scan(const std::vector<std::filesystem::path> &roots,
+       std::unordered_map<std::string, std::filesystem::path> &result,
+       const std::function<bool()> &canceled);
+
+private:
+  // Root index, nesting depth and path.
+  typedef std::tuple<size_t, size_t, std::filesystem::path> ScanItem;
+
+  void
+  listDir(const ScanItem &dir, std::vector<ScanItem> &subdirs,
+          std::vector<ScanItem> &files);
+
+#ifndef USE_OPENMP
+  void
+  worker(const size_t &n);
+#endif
+#ifdef USE_OPENMP
+  void
+  scanTask(const ScanItem &dir);
+#endif
+
+  int thr_num = 1;
+  std::function<bool()> canceled;
+  std::vector<std::vector<ScanItem>> found;
+
+#ifndef USE_OPENMP
+  std::vector<ScanItem> queue;
+  size_t busy = 0;
+  bool stop = false;
+  std::mutex queue_mtx;
+  std::condition_variable queue_var;
+#endif
+};
+
+#endif // DIRSCANNER_H
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef DUPLICATEINDEX_H
+#define DUPLICATEINDEX_H
+
+#include <BookMeta.h>
+#include <FileParseEntry.h>
+#include <TextFolder.h>
+#include <filesystem>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+#ifndef USE_OPENMP
+#include <mutex>
+#endif
+
+class DuplicateRecord
+{
+public:
+  uint64_t key = 0;
+  std::string full_key;
+  uint32_t arch_id = 0;
+  uint64_t lib_id = 0;
+  uint64_t size = 0;
+  std::string book_path;
+  std::string date;
+};
+
+class DuplicateIndex
+{
+public:
+  DuplicateIndex();
+
+  virtual ~DuplicateIndex();
+
+  void
+  addArchive(const FileParseEntry &fpe, const std::vector<BookMeta> &meta,
+             const std::string &source);
+
+  size_t
+  resolve();
+
+  bool
+  writeReport(const std::filesystem::path &report_path);
+
+  size_t
+  removeOlder(std::vector<FileParseEntry> &base);
+
+private:
+  uint32_t
+  archiveId(const std::string &arch_name);
+
+  void
+  addRecord(DuplicateRecord &&rec);
+
+  bool
+  newer(const DuplicateRecord &first, const DuplicateRecord &second);
+
+  // Authors and titles are compared by the same keys as are used for
+  // search.
+  TextFolder folder = TextFolder(false);
+
+  size_t shards_num = 64;
+  std::vector<std::vector<DuplicateRecord>> shards;
+
+  std::vector<std::string> arch_names;
+  std::unordered_map<std::string, uint32_t> arch_ids;
+
+  std::vector<std::unordered_set<std::string>> removed;
+
+  // Groups of duplicates for report: first record of each group is the
+  // newest one.
+  std::vector<std::vector<DuplicateRecord>> groups;
+
+#ifndef USE_OPENMP
+  std::vector<std::mutex> shards_mtx;
+  std::mutex arch_mtx;
+#endif
+#ifdef USE_OPENMP
+  std::vector<omp_lock_t> shards_mtx;
+  omp_lock_t arch_mtx;
+#endif
+};
+
+#endif // DUPLICATEINDEX_H
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef FB2PARSER_H
+#define FB2PARSER_H
+
+#include <BookMeta.h>
+#include <FileParseEntry.h>
+#include <string>
+
+// Minimal parser of fb2 headers. Only elements needed for collection base
+// and book cache are read, whole document is not validated.
+class Fb2Parser
+{
+public:
+  Fb2Parser();
+
+  // Fills book record from <description> element. Book path is not set.
+  bool
+  description(const std::string &book, BookParseEntry &bpe);
+
+  // Returns content of first element with given name starting from n_beg
+  // and ending before n_lim. n_beg is set after the element or to npos if
+  // element has not been found.
+  std::string
+  tagContent(const std::string &xml, const std::string &tag,
+             std::string::size_type &n_beg, std::string::size_type n_lim);
+
+  std::string
+  attribute(const std::string &tag, const std::string &name);
+
+  // Converts part of book to UTF-8 from encoding declared in XML
+  // declaration of book. Encoding is detected if declaration is absent or
+  // declared encoding is not supported.
+  void
+  toUtf8(const std::string &book, std::string &part);
+
+  // Removes markup, decodes entities and collapses whitespaces.
+  std::string
+  text(const std::string &xml);
+
+private:
+  std::string
+  authorName(const std::string &author);
+
+  void
+  appendCodePoint(std::string &result, const uint32_t &cp);
+};
+
+#endif // FB2PARSER_H
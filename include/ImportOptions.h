@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef IMPORTOPTIONS_H
+#define IMPORTOPTIONS_H
+
+#include <vector>
+
+class ImportOptions
+{
+public:
+  enum Priority
+  {
+    Normal,
+    Low,
+    Idle
+  };
+
+  enum Reader
+  {
+    Standard,
+    Pread,
+    IoUring
+  };
+
+  enum SearchKeys
+  {
+    NoKeys,
+    FoldedKeys,
+    LatinKeys
+  };
+
+  bool keep_newest_duplicate = false;
+
+  // Annotations and cover thumbnails are extracted to book_cache during
+  // import.
+  bool extract_cache = false;
+
+  // Archives without .inp files are imported using fb2 headers.
+  bool import_orphans = false;
+
+  // Base is exported to catalog.sqlite in collection directory.
+  bool export_sqlite = false;
+
+  // Timeline of worker threads is written to trace.json in collection
+  // directory.
+  bool write_trace = false;
+
+  // Priority of worker threads.
+  int priority = Normal;
+
+  // Archives are read for hashing by hasher itself or by ReadEngine.
+  int reader = Standard;
+
+  // Reads in flight per thread for io_uring reader.
+  int queue_depth = 16;
+
+  // Archives processed simultaneously on one disk, 0 - no limit.
+  int device_threads = 0;
+
+  // Normalized search keys of authors, titles and series are written to
+  // search_keys file in collection directory.
+  int search_keys = NoKeys;
+
+  // Numbers of CPUs worker threads are bound to, empty - no binding.
+  std::vector<int> cpus;
+};
+
+#endif // IMPORTOPTIONS_H
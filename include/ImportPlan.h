@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef IMPORTPLAN_H
+#define IMPORTPLAN_H
+
+#include <cstddef>
+
+class ImportPlan
+{
+public:
+  size_t matched_inp = 0;
+  size_t unmatched_inp = 0;
+  size_t books = 0;
+  size_t absent_books = 0;
+
+  // All sizes are in bytes, speeds are in bytes per second, times are in
+  // seconds.
+  double bytes_to_hash = 0.0;
+  double base_size = 0.0;
+  double read_speed = 0.0;
+  double hash_speed = 0.0;
+  double parse_time = 0.0;
+  double estimated_time = 0.0;
+};
+
+#endif // IMPORTPLAN_H
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef IMPORTQUEUEGUI_H
+#define IMPORTQUEUEGUI_H
+
+#include <AuxFunc.h>
+#include <CollectionProcess.h>
+#include <ImportScheduler.h>
+#include <atomic>
+#include <glibmm-2.68/glibmm/dispatcher.h>
+#include <gtkmm-4.0/gtkmm/button.h>
+#include <gtkmm-4.0/gtkmm/entry.h>
+#include <gtkmm-4.0/gtkmm/grid.h>
+#include <gtkmm-4.0/gtkmm/label.h>
+#include <gtkmm-4.0/gtkmm/progressbar.h>
+#include <gtkmm-4.0/gtkmm/window.h>
+#include <list>
+
+class ImportJob
+{
+public:
+  ImportJob();
+
+  virtual ~ImportJob();
+
+  enum State
+  {
+    Pending,
+    Running,
+    Completed,
+    Interrupted
+  };
+
+  std::vector<ImportSource> sources;
+  std::string coll_name;
+  ImportOptions options;
+
+  CollectionProcess *coll_proc = nullptr;
+
+  std::atomic<int> state;
+  std::atomic<double> parsed_bytes;
+  std::atomic<double> total_size;
+
+  Gtk::ProgressBar *progress = nullptr;
+  Gtk::Label *status = nullptr;
+  Gtk::Button *cancel = nullptr;
+};
+
+class ImportQueueGui
+{
+public:
+  ImportQueueGui(Gtk::Window *parent_window,
+                 const std::shared_ptr<AuxFunc> &af, const int &thr_num);
+
+  virtual ~ImportQueueGui();
+
+  void
+  createWindow();
+
+  bool
+  addJob(const std::vector<ImportSource> &sources,
+         const std::string &coll_name, const ImportOptions &options);
+
+  std::function<void()> signal_closed;
+
+private:
+  void
+  startQueue();
+
+  void
+  startJob(ImportJob &job);
+
+  void
+  updateJobs();
+
+  bool
+  running();
+
+  int
+  entryNumber(Gtk::Entry *entry);
+
+  Gtk::Window *parent_window;
+  std::shared_ptr<AuxFunc> af;
+  int thr_num;
+
+  Gtk::Window *main_window = nullptr;
+  Gtk::Grid *jobs_grid = nullptr;
+  Gtk::Entry *thr_budget = nullptr;
+  Gtk::Entry *io_budget = nullptr;
+  Gtk::Button *start = nullptr;
+
+  std::list<ImportJob> jobs;
+  int jobs_rows = 0;
+
+  std::shared_ptr<ImportScheduler> scheduler;
+
+  Glib::Dispatcher *progress_disp = nullptr;
+};
+
+#endif // IMPORTQUEUEGUI_H
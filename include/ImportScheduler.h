@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef IMPORTSCHEDULER_H
+#define IMPORTSCHEDULER_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+class ImportScheduler
+{
+public:
+  ImportScheduler(const int &thr_budget, const int &io_budget);
+
+  bool
+  acquireThread(const std::function<bool()> &canceled);
+
+  void
+  releaseThread();
+
+  // Takes up to number free threads without waiting (for threads, which
+  // job creates in addition to its workers). Returns number of taken
+  // threads.
+  int
+  tryAcquireThreads(const int &number);
+
+  void
+  releaseThreads(const int &number);
+
+  bool
+  acquireIo(const std::function<bool()> &canceled);
+
+  void
+  releaseIo();
+
+  void
+  wakeAll();
+
+private:
+  bool
+  acquire(int &used, const int &budget,
+          const std::function<bool()> &canceled);
+
+  void
+  release(int &used);
+
+  int thr_budget = 1;
+  int io_budget = 1;
+  int thr_used = 0;
+  int io_used = 0;
+  std::mutex mtx;
+  std::condition_variable var;
+};
+
+#endif // IMPORTSCHEDULER_H
@@ -0,0 +1,33 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef IMPORTSOURCE_H
+#define IMPORTSOURCE_H
+
+#include <filesystem>
+
+class ImportSource
+{
+public:
+  ImportSource();
+
+  ImportSource(const std::filesystem::path &inpx_path,
+               const std::filesystem::path &books_path);
+
+  std::filesystem::path inpx_path;
+  std::filesystem::path books_path;
+};
+
+#endif // IMPORTSOURCE_H
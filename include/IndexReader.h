@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef INDEXREADER_H
+#define INDEXREADER_H
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Reads index files written by BaseIndex (see BaseIndex.h for format).
+class IndexReader
+{
+public:
+  IndexReader();
+
+  bool
+  open(const std::filesystem::path &index_path);
+
+  std::vector<std::string>
+  keys() const;
+
+  bool
+  find(const std::string &key, std::vector<uint64_t> &offsets) const;
+
+private:
+  uint64_t
+  get64(const size_t &pos) const;
+
+  std::string data;
+
+  // Key and position of its offsets number in data.
+  std::vector<std::pair<std::string, size_t>> directory;
+};
+
+#endif // INDEXREADER_H
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef INPENCODING_H
+#define INPENCODING_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+class InpEncoding
+{
+public:
+  InpEncoding();
+
+  enum Encoding
+  {
+    Utf8,
+    Cp1251,
+    Koi8r
+  };
+
+  // Converts buffer to UTF-8 line by line. Lines consisting mostly of
+  // valid UTF-8 sequences are not transcoded, invalid bytes of them are
+  // replaced by U+FFFD. Other lines are transcoded from encoding detected
+  // by all such lines. Returns encoding of transcoded lines.
+  Encoding
+  toUtf8(std::string &buf);
+
+  bool
+  validUtf8(const std::string_view &buf);
+
+  Encoding
+  detect(const std::string_view &buf);
+
+  void
+  transcode(std::string &buf, const Encoding &enc);
+
+private:
+  // Counts valid multibyte UTF-8 sequences and bytes, which are not part of
+  // them. Invalid bytes are counted by halves 0xC0-0xDF and 0xE0-0xFF too.
+  void
+  scan(const std::string_view &buf, size_t &valid, size_t &invalid,
+       size_t &lower_half, size_t &upper_half);
+
+  size_t
+  sequenceLength(const unsigned char *data, const size_t &size);
+
+  void
+  appendUtf8(std::string &result, const std::string_view &buf);
+
+  void
+  appendTranscoded(std::string &result, const std::string_view &buf,
+                   const uint16_t *table);
+
+  size_t
+  asciiPrefix(const char *data, const size_t &size);
+};
+
+#endif // INPENCODING_H
@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef INPENTRY_H
+#define INPENTRY_H
+
+#include <ArchEntry.h>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+class InpEntry
+{
+public:
+  ArchEntry entry;
+  std::filesystem::path inpx_path;
+  std::filesystem::path arch_path;
+  double arch_size = 0.0;
+  std::filesystem::file_time_type arch_mtime;
+  uint32_t inp_crc = 0;
+  bool inp_crc_known = false;
+  // Local header offset and size of .inp file stored in .inpx without
+  // compression.
+  bool inp_stored = false;
+  uint64_t inp_offset = 0;
+  uint64_t inp_size = 0;
+  // Deflated .inp file is unpacked from mapped .inpx directly, inp_offset
+  // and inp_size are set for it too.
+  bool inp_deflated = false;
+  uint64_t inp_comp_size = 0;
+  // Archive has no .inp file, records are made from fb2 headers.
+  bool orphan = false;
+  // Known hash of archive. Archive is not hashed again if it is set.
+  std::string file_hash;
+  // Position of archive in base, which is sorted by archive paths.
+  size_t base_order = 0;
+};
+
+#endif // INPENTRY_H
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef INPPARSER_H
+#define INPPARSER_H
+
+#include <BookMeta.h>
+#include <BookParseEntry.h>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Parser of .inp records. Scratch buffer is reused by all records, so one
+// parser object is used by one thread.
+class InpParser
+{
+public:
+  InpParser();
+
+  // Parses lines ending in range [beg, end) of .inp buffer. Parsing is
+  // stopped if canceled returns true.
+  void
+  parseChunk(const std::string_view &fl_str,
+             const std::string::size_type &beg,
+             const std::string::size_type &end,
+             std::vector<BookParseEntry> &books, std::vector<BookMeta> &meta,
+             const std::function<bool()> &canceled);
+
+  void
+  parseEntry(const std::string_view &ent, std::vector<BookParseEntry> &books,
+             std::vector<BookMeta> &meta);
+
+  void
+  parseNames(const std::string_view &field, std::string &result,
+             const bool &trim);
+
+private:
+  std::string scratch;
+};
+
+#endif // INPPARSER_H
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef INPXCACHE_H
+#define INPXCACHE_H
+
+#include <BookMeta.h>
+#include <BookParseEntry.h>
+#include <MappedFile.h>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+#ifndef USE_OPENMP
+#include <mutex>
+#endif
+
+// Parsed .inp files of one .inpx file. Cache file name is hash sum of .inpx
+// file, so cache is used only while .inpx file is not changed. All numbers
+// are little-endian.
+//
+// "MLIC" (4 bytes), version (uint8_t, 3)
+// .inp files number, records number, strings size (uint64_t each)
+// for every .inp file sorted by name:
+//   name offset and size in strings, first record, records number and
+//   checksum of records (uint64_t each)
+// for every record (88 bytes):
+//   path, author, name, series, genre and date offsets in strings
+//   (uint64_t) and sizes (uint32_t)
+//   file size and LIBID (uint64_t each)
+// strings (UTF-8, equal strings are written once)
+//
+// Series number is separated from series name by series_number_separator
+// (see BookMeta.h).
+//
+// Checksum is 64-bit FNV-1a of sizes (uint32_t) and contents of all string
+// fields, file sizes and LIBIDs of records of .inp file. Entry with wrong
+// checksum is not used.
+// Records of one .inp file in format of cache file, string offsets point
+// to strings of entry.
+class InpxCacheEntry
+{
+public:
+  std::string records;
+  std::string strings;
+  uint64_t num = 0;
+  uint64_t sum = 0;
+};
+
+class InpxCache
+{
+public:
+  InpxCache();
+
+  virtual ~InpxCache();
+
+  bool
+  open(const std::filesystem::path &cache_dir, const std::string &key);
+
+  bool
+  find(const std::string &inp_name, std::vector<BookParseEntry> &books,
+       std::vector<BookMeta> &meta) const;
+
+  void
+  add(const std::string &inp_name, const std::vector<BookParseEntry> &books,
+      const std::vector<BookMeta> &meta);
+
+  bool
+  save();
+
+private:
+  bool
+  inpEntry(const size_t &n, std::string_view &name, uint64_t &first,
+           uint64_t &num, uint64_t &sum) const;
+
+  void
+  addChecksum(uint64_t &sum, const std::string_view &str) const;
+
+  void
+  addChecksum(uint64_t &sum, const uint64_t &val, const size_t &size) const;
+
+  static uint64_t
+  get64(const std::string_view &buf, const size_t &pos);
+
+  static uint32_t
+  get32(const std::string_view &buf, const size_t &pos);
+
+  static void
+  put64(std::string &buf, uint64_t val);
+
+  static void
+  put32(std::string &buf, uint32_t val);
+
+  static uint64_t
+  processId();
+
+  void
+  removeOld();
+
+  std::filesystem::path cache_dir;
+  std::filesystem::path cache_path;
+
+  std::unique_ptr<MappedFile> mapped;
+  std::string_view data;
+  uint64_t inp_num = 0;
+  uint64_t records_num = 0;
+  size_t records_pos = 0;
+  size_t strings_pos = 0;
+
+  // Records of parsed .inp files, which are absent in cache file.
+  std::map<std::string, InpxCacheEntry> added;
+
+  size_t max_files = 8;
+
+#ifndef USE_OPENMP
+  std::mutex added_mtx;
+#endif
+#ifdef USE_OPENMP
+  omp_lock_t added_mtx;
+#endif
+};
+
+#endif // INPXCACHE_H
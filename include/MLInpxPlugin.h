@@ -16,8 +16,12 @@
 #ifndef MLINPXPLUGIN_H
 #define MLINPXPLUGIN_H
 
+#include <ImportQueueGui.h>
 #include <MLPlugin.h>
+#include <gtkmm-4.0/gtkmm/checkbutton.h>
+#include <gtkmm-4.0/gtkmm/dropdown.h>
 #include <gtkmm-4.0/gtkmm/entry.h>
+#include <gtkmm-4.0/gtkmm/label.h>
 
 #ifndef ML_GTK_OLD
 #include <gtkmm-4.0/gtkmm/filedialog.h>
@@ -60,7 +64,36 @@ protected:
 #endif
 
   void
-  checkEntries();
+  checkEntries(const bool &queue);
+
+  void
+  addToQueue(const std::vector<ImportSource> &sources,
+             const std::string &coll_name, const ImportOptions &options);
+
+  void
+  planImport();
+
+  void
+  watchCollection();
+
+  void
+  verifyCollection();
+
+  void
+  addSource();
+
+  void
+  updateSources();
+
+  std::vector<ImportSource>
+  importSources(const std::filesystem::path &inpx_path,
+                const std::filesystem::path &books_path);
+
+  ImportOptions
+  importOptions();
+
+  int
+  threadsNumber();
 
   void
   confirmationDialog(const std::filesystem::path &inpx_path,
@@ -73,6 +106,25 @@ protected:
   Gtk::Entry *path_to_books;
   Gtk::Entry *collection_name;
   Gtk::Entry *thr_num;
+  Gtk::Entry *rate_limit;
+  Gtk::DropDown *priority;
+  Gtk::Entry *cpus;
+  Gtk::DropDown *reader;
+  Gtk::Entry *queue_depth;
+  Gtk::Entry *device_threads;
+  Gtk::CheckButton *keep_newest;
+  Gtk::CheckButton *extract_cache;
+  Gtk::CheckButton *import_orphans;
+#ifdef USE_SQLITE
+  Gtk::CheckButton *export_sqlite;
+#endif
+  Gtk::CheckButton *write_trace;
+  Gtk::DropDown *search_keys;
+  Gtk::Label *sources_lab;
+
+  std::vector<ImportSource> extra_sources;
+
+  ImportQueueGui *import_queue = nullptr;
 };
 
 extern "C"
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef READENGINE_H
+#define READENGINE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef __linux
+#include <sys/uio.h>
+#endif
+
+// Reads whole file to memory. IoUring engine keeps queue_depth reads of
+// block_size bytes in flight using io_uring with registered buffers, Pread
+// engine reads blocks one by one. IoUring engine falls back to Pread if
+// io_uring is not available (kernels older than 5.1, disabled io_uring,
+// platforms other than Linux).
+class ReadEngine
+{
+public:
+  enum Type
+  {
+    Pread,
+    IoUring
+  };
+
+  ReadEngine(const int &type, const unsigned &queue_depth);
+
+  virtual ~ReadEngine();
+
+  int
+  engineType() const;
+
+  // Memory taken by engine buffers.
+  uint64_t
+  memorySize() const;
+
+  bool
+  readFile(const std::filesystem::path &file_path, std::string &result,
+           const std::function<bool()> &canceled);
+
+private:
+  bool
+  readPread(const std::filesystem::path &file_path, std::string &result,
+            const std::function<bool()> &canceled);
+
+#ifdef __linux
+  bool
+  setupRing();
+
+  void
+  closeRing();
+
+  bool
+  readRing(const int &fd, std::string &result,
+           const std::function<bool()> &canceled);
+
+  void
+  submit(const int &fd, const unsigned &slot);
+
+  int ring_fd = -1;
+  void *sq_ptr = nullptr;
+  size_t sq_size = 0;
+  void *cq_ptr = nullptr;
+  size_t cq_size = 0;
+  void *sqes = nullptr;
+  size_t sqes_size = 0;
+  unsigned *sq_tail = nullptr;
+  unsigned *sq_mask = nullptr;
+  unsigned *sq_array = nullptr;
+  unsigned *cq_head = nullptr;
+  unsigned *cq_tail = nullptr;
+  unsigned *cq_mask = nullptr;
+  void *cqes = nullptr;
+  bool registered = false;
+  unsigned to_submit = 0;
+
+  std::unique_ptr<char[]> buffers;
+  std::vector<struct iovec> iovs;
+  // File offset and length of read of every slot.
+  std::vector<uint64_t> slot_offset;
+  std::vector<size_t> slot_length;
+#endif
+
+  int type = Pread;
+  unsigned queue_depth = 8;
+  size_t block_size = 1048576;
+};
+
+#endif // READENGINE_H
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef READENGINEPOOL_H
+#define READENGINEPOOL_H
+
+#include <ReadEngine.h>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class ReadEngineSlot
+{
+public:
+  std::unique_ptr<ReadEngine> engine;
+  std::string buf;
+  // Memory taken by buffer and engine, counted against memory limit.
+  uint64_t reserved = 0;
+  bool busy = false;
+};
+
+// Read engines and their buffers are reused by all archives of import, so
+// io_uring is set up once per simultaneously hashed archive, not for every
+// archive. Buffers and engines of all threads together take no more than
+// memory_limit bytes: if file does not fit, acquire() returns nullptr and
+// caller hashes file without reading it to memory.
+class ReadEnginePool
+{
+public:
+  ReadEnginePool(const int &type, const unsigned &queue_depth,
+                 const uint64_t &memory_limit);
+
+  ReadEngineSlot *
+  acquire(const uint64_t &size);
+
+  void
+  release(ReadEngineSlot *slot);
+
+private:
+  int type;
+  unsigned queue_depth;
+  uint64_t memory_limit;
+  uint64_t reserved = 0;
+  std::vector<std::unique_ptr<ReadEngineSlot>> slots;
+
+  std::mutex mtx;
+};
+
+#endif // READENGINEPOOL_H
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SQLITEEXPORT_H
+#define SQLITEEXPORT_H
+
+#include <FileParseEntry.h>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#ifdef USE_SQLITE
+#include <sqlite3.h>
+#endif
+
+// Writes collection base to SQLite database:
+//
+// collection(books_path)
+// archives(id, path, hash) - path is relative to books_path
+// books(id, archive_id, path, author, title, series, genre, date)
+//
+// Fields of books have the same format as in base. Indexes are created for
+// archives(path) and books(archive_id), books(author), books(title),
+// books(series) and books(genre). Export is not available if plugin has been
+// built without SQLite.
+class SqliteExport
+{
+public:
+  SqliteExport();
+
+  bool
+  write(const std::filesystem::path &db_path,
+        const std::filesystem::path &books_path,
+        const std::vector<FileParseEntry> &base);
+
+#ifdef USE_SQLITE
+private:
+  bool
+  exec(const std::string &sql);
+
+  bool
+  prepareBooks(const size_t &rows, sqlite3_stmt **stmt);
+
+  bool
+  step(sqlite3_stmt *stmt);
+
+  sqlite3 *db = nullptr;
+
+  // Rows inserted by one statement and by one transaction.
+  size_t batch_rows = 64;
+  size_t transaction_rows = 262144;
+#endif
+};
+
+#endif // SQLITEEXPORT_H
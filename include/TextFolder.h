@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef TEXTFOLDER_H
+#define TEXTFOLDER_H
+
+#include <string>
+#include <vector>
+
+// Converts UTF-8 strings to search keys: Latin, Greek and Cyrillic letters
+// are converted to lower case, diacritics are removed from Latin letters,
+// "ё" is replaced by "е", punctuation and spaces are replaced by single
+// space. Optionally Cyrillic letters are transliterated to Latin ones.
+// Conversion of every code point is taken from table built in constructor.
+class TextFolder
+{
+public:
+  TextFolder(const bool &transliterate);
+
+  std::string
+  fold(const std::string &str) const;
+
+private:
+  void
+  set(const char32_t &cp, const std::string &val);
+
+  std::string
+  toUtf8(const char32_t &cp);
+
+  // Code points below table size only, other ones are kept as they are.
+  std::vector<std::string> table;
+  std::string separator = " ";
+};
+
+#endif // TEXTFOLDER_H
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef THREADPRIORITY_H
+#define THREADPRIORITY_H
+
+#include <ImportOptions.h>
+
+#ifdef __linux
+#include <sched.h>
+#endif
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Lowers priority of calling thread and binds it to CPUs set in options.
+// Previous settings are restored on destruction.
+class ThreadPriority
+{
+public:
+  ThreadPriority(const ImportOptions &options);
+
+  virtual ~ThreadPriority();
+
+private:
+#ifdef __linux
+  bool
+  restorable();
+#endif
+
+  int priority = ImportOptions::Normal;
+  bool affinity_set = false;
+
+#ifdef __linux
+  int policy = 0;
+  sched_param param;
+  int nice = 0;
+  int ioprio = 0;
+  bool io_only = false;
+  cpu_set_t affinity;
+#endif
+#ifdef _WIN32
+  int thr_priority = THREAD_PRIORITY_NORMAL;
+  DWORD_PTR affinity = 0;
+#endif
+};
+
+#endif // THREADPRIORITY_H
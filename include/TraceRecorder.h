@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef TRACERECORDER_H
+#define TRACERECORDER_H
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+#ifndef USE_OPENMP
+#include <mutex>
+#endif
+
+class TraceEvent
+{
+public:
+  // Name must be string literal.
+  const char *name = nullptr;
+  char phase = 'B';
+  int64_t time = 0;
+  std::string detail;
+};
+
+class TraceBuffer
+{
+public:
+  int tid = 0;
+  std::vector<TraceEvent> events;
+};
+
+// Records begin and end events of operations of every thread. Every thread
+// writes to its own buffer, so recording does not need locks (lock is taken
+// once, when thread records its first event). Events are written in Chrome
+// trace event format (can be opened in Perfetto or chrome://tracing) after
+// all threads have finished.
+class TraceRecorder
+{
+public:
+  TraceRecorder();
+
+  virtual ~TraceRecorder();
+
+  void
+  begin(const char *name, const std::string &detail = std::string());
+
+  void
+  end(const char *name);
+
+  bool
+  write(const std::filesystem::path &trace_path);
+
+private:
+  TraceBuffer *
+  threadBuffer();
+
+  std::string
+  escape(const std::string &str);
+
+  uint64_t id = 0;
+  std::chrono::steady_clock::time_point start;
+  std::vector<std::unique_ptr<TraceBuffer>> buffers;
+
+#ifndef USE_OPENMP
+  std::mutex buffers_mtx;
+#endif
+#ifdef USE_OPENMP
+  omp_lock_t buffers_mtx;
+#endif
+};
+
+// Records begin event on construction and end event on destruction. Does
+// nothing if recorder is nullptr.
+class TraceScope
+{
+public:
+  TraceScope(TraceRecorder *recorder, const char *name,
+             const std::string &detail = std::string());
+
+  virtual ~TraceScope();
+
+private:
+  TraceRecorder *recorder;
+  const char *name;
+};
+
+#endif // TRACERECORDER_H
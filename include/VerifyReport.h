@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef VERIFYREPORT_H
+#define VERIFYREPORT_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class VerifyReport
+{
+public:
+  size_t checked = 0;
+
+  // Paths of archives relative to collection books directory.
+  std::vector<std::string> mismatched;
+  std::vector<std::string> missing;
+  std::vector<std::string> extra;
+
+  // Size in bytes, time in seconds.
+  double bytes_hashed = 0.0;
+  double elapsed_time = 0.0;
+};
+
+#endif // VERIFYREPORT_H
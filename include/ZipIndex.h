@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ZIPINDEX_H
+#define ZIPINDEX_H
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+
+class ZipIndex
+{
+public:
+  ZipIndex();
+
+  bool
+  readCentralDirectory(const std::filesystem::path &zip_path);
+
+  bool
+  contains(const std::string &name) const;
+
+  // Returns true if UTF-8 name is not ASCII and archive has files with
+  // names in unknown code page, so presence of file can not be checked.
+  bool
+  uncheckable(const std::string &name) const;
+
+  bool
+  crc32(const std::string &name, uint32_t &crc) const;
+
+  bool
+  storedEntry(const std::string &name, uint64_t &offset,
+              uint64_t &size) const;
+
+  static bool
+  storedData(const std::string_view &zip, const uint64_t &offset,
+             const uint64_t &size, std::string_view &result);
+
+  bool
+  deflatedEntry(const std::string &name, uint64_t &offset,
+                uint64_t &comp_size, uint64_t &size) const;
+
+  // Unpacks deflated file to result. Memory of result is reused, if it is
+  // large enough.
+  static bool
+  inflatedData(const std::string_view &zip, const uint64_t &offset,
+               const uint64_t &comp_size, const uint64_t &size,
+               std::string &result);
+
+  // Unpacks beginning of deflated file to result until it contains marker.
+  // Whole file is unpacked, if marker is absent.
+  static bool
+  inflatedPrefix(const std::string_view &zip, const uint64_t &offset,
+                 const uint64_t &comp_size, const uint64_t &size,
+                 const std::string &marker, std::string &result);
+
+  // File names and their CRC-32 values.
+  std::unordered_map<std::string, uint32_t> names;
+
+  // Non-ASCII names of files, which are not marked as UTF-8 (bit 11 of
+  // general purpose flag). Such names are usually in DOS code page and are
+  // converted by LibArchive according to locale.
+  std::unordered_set<std::string> legacy_names;
+
+  // Local header offsets and sizes of files stored without compression.
+  std::unordered_map<std::string, std::pair<uint64_t, uint64_t>> stored;
+
+  // Local header offsets, compressed and uncompressed sizes of deflated
+  // files.
+  std::unordered_map<std::string, std::tuple<uint64_t, uint64_t, uint64_t>>
+      deflated;
+
+private:
+  static uint16_t
+  get16(const char *buf);
+
+  static uint32_t
+  get32(const char *buf);
+
+  static uint64_t
+  get64(const char *buf);
+};
+
+#endif // ZIPINDEX_H
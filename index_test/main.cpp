@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <BaseIndex.h>
+#include <BookMeta.h>
+#include <IndexReader.h>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+
+// Writes indexes of small base by BaseIndex and reads them back by
+// IndexReader. Offsets are computed here independently by layout of
+// CollectionProcess::baseEntry().
+
+typedef std::map<std::string, std::vector<uint64_t>> Expected;
+
+static FileParseEntry
+makeEntry(const int &arch, const int &books_num)
+{
+  FileParseEntry fpe;
+  fpe.file_rel_path = "arch" + std::to_string(arch) + ".zip";
+  fpe.file_hash = std::string(40, 'a' + arch);
+  for(int i = 0; i < books_num; i++)
+    {
+      BookParseEntry bpe;
+      bpe.book_path = std::to_string(arch * 100 + i) + ".fb2";
+      bpe.book_author = "Author " + std::to_string(i % 3);
+      if(i % 4 == 0)
+        {
+          // Author repeated in one record is indexed once.
+          bpe.book_author += ", Author " + std::to_string(i % 3)
+                             + ", Автор Второй";
+        }
+      bpe.book_name = "Title " + std::to_string(i);
+      if(i % 4 == 0)
+        {
+          bpe.book_series = "Series " + std::to_string(i % 5);
+          bpe.book_series.push_back(series_number_separator);
+          bpe.book_series += std::to_string(i);
+        }
+      else if(i % 4 == 2)
+        {
+          // Series name ends with number, but series number is absent.
+          bpe.book_series = "Series " + std::to_string(i % 5) + " 2033";
+        }
+      bpe.book_genre = "sf, prose";
+      bpe.book_date = "2020-01-01";
+      fpe.books.emplace_back(std::move(bpe));
+    }
+  return fpe;
+}
+
+static void
+addExpected(Expected &authors, Expected &genres, Expected &series,
+            const FileParseEntry &fpe, const uint64_t &entry_offset)
+{
+  uint64_t offset = entry_offset + 2 + fpe.file_rel_path.size() + 2
+                    + fpe.file_hash.size();
+  for(auto it = fpe.books.begin(); it != fpe.books.end(); it++)
+    {
+      for(const std::string &a :
+          { std::string("Author 0"), std::string("Author 1"),
+            std::string("Author 2"), std::string("Автор Второй") })
+        {
+          if(it->book_author.find(a) != std::string::npos)
+            {
+              authors[a].push_back(offset);
+            }
+        }
+      genres["sf"].push_back(offset);
+      genres["prose"].push_back(offset);
+      if(!it->book_series.empty())
+        {
+          series[it->book_series.substr(
+                     0, it->book_series.find(series_number_separator))]
+              .push_back(offset);
+        }
+      offset += 8 + 6 * 2 + it->book_path.size() + it->book_author.size()
+                + it->book_name.size() + it->book_series.size()
+                + it->book_genre.size() + it->book_date.size();
+    }
+}
+
+static bool
+check(const std::filesystem::path &index_path, const Expected &expected)
+{
+  IndexReader reader;
+  if(!reader.open(index_path))
+    {
+      std::cout << "cannot open " << index_path << std::endl;
+      return false;
+    }
+  std::vector<std::string> keys = reader.keys();
+  if(keys.size() != expected.size())
+    {
+      std::cout << index_path << ": " << keys.size() << " keys, expected "
+                << expected.size() << std::endl;
+      return false;
+    }
+  auto it_k = keys.begin();
+  for(auto it = expected.begin(); it != expected.end(); it++, it_k++)
+    {
+      std::vector<uint64_t> offsets;
+      if(*it_k != it->first || !reader.find(it->first, offsets)
+         || offsets != it->second)
+        {
+          std::cout << index_path << ": wrong key or offsets of \""
+                    << it->first << "\"" << std::endl;
+          return false;
+        }
+    }
+  std::vector<uint64_t> offsets;
+  if(reader.find("Absent", offsets) || !offsets.empty())
+    {
+      std::cout << index_path << ": absent key is found" << std::endl;
+      return false;
+    }
+  return true;
+}
+
+int
+main(int argc, char **argv)
+{
+  std::filesystem::path dir = std::filesystem::temp_directory_path();
+  if(argc > 1)
+    {
+      dir = std::filesystem::u8path(argv[1]);
+    }
+  dir /= std::filesystem::u8path("index_test");
+  std::filesystem::create_directories(dir);
+
+  BaseIndex index(ImportOptions::FoldedKeys);
+  Expected authors;
+  Expected genres;
+  Expected series;
+  // Entries are placed after book path record at base beginning.
+  uint64_t offset = 64;
+  for(int i = 0; i < 5; i++)
+    {
+      FileParseEntry fpe = makeEntry(i, 10 + i);
+      index.addEntry(fpe, offset);
+      addExpected(authors, genres, series, fpe, offset);
+      offset += 1000;
+    }
+  if(!index.write(dir))
+    {
+      std::cout << "BaseIndex::write failed" << std::endl;
+      return 1;
+    }
+
+  bool result = check(dir / std::filesystem::u8path("authors.idx"), authors);
+  result = check(dir / std::filesystem::u8path("genres.idx"), genres)
+           && result;
+  result = check(dir / std::filesystem::u8path("series.idx"), series)
+           && result;
+
+  std::fstream f;
+  f.open(dir / std::filesystem::u8path("search_keys"),
+         std::ios_base::in | std::ios_base::binary);
+  std::string magic(4, 0);
+  f.read(magic.data(), magic.size());
+  if(!f || magic != "MLSK")
+    {
+      std::cout << "search_keys file is not written" << std::endl;
+      result = false;
+    }
+  f.close();
+
+  // Truncated file must be rejected.
+  std::filesystem::path idx = dir / std::filesystem::u8path("authors.idx");
+  std::filesystem::resize_file(idx, std::filesystem::file_size(idx) - 1);
+  IndexReader reader;
+  if(reader.open(idx))
+    {
+      std::cout << "truncated index is accepted" << std::endl;
+      result = false;
+    }
+
+  std::filesystem::remove_all(dir);
+  if(result)
+    {
+      std::cout << "Index test passed" << std::endl;
+      return 0;
+    }
+  return 1;
+}
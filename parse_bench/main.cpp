@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <InpParser.h>
+#include <ZipIndex.h>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <new>
+#include <zlib.h>
+
+// Measures speed and heap allocations of .inp parsing and of unpacking of
+// deflated .inp files to reused buffer. Usage: parse_bench [file.inp]
+// (synthetic records are used if file is not given).
+
+static size_t allocations = 0;
+
+void *
+operator new(size_t size)
+{
+  allocations++;
+  void *result = std::malloc(size > 0 ? size : 1);
+  if(!result)
+    {
+      throw std::bad_alloc();
+    }
+  return result;
+}
+
+void
+operator delete(void *ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void
+operator delete(void *ptr, size_t) noexcept
+{
+  std::free(ptr);
+}
+
+static std::string
+syntheticInp(const size_t &records)
+{
+  std::string result;
+  const std::string d("\x04");
+  for(size_t i = 0; i < records; i++)
+    {
+      result += "Толстой,Лев,Николаевич:";
+      result += "Иванов,Иван,:" + d + "prose_classic:" + d;
+      result += "Война и мир. Том " + std::to_string(i) + d;
+      result += "Эпопея" + d + std::to_string(i % 10) + d;
+      result += std::to_string(100000 + i) + d + std::to_string(i * 7) + d;
+      result += std::to_string(100000 + i) + d + d + "fb2" + d;
+      result += "2020-01-01" + d + "ru" + d + d + "\r\n";
+    }
+  return result;
+}
+
+// Strings longer than small string buffer are allocated by std::string
+// anyway, they are stored in base.
+static size_t
+storedStrings(const std::vector<BookParseEntry> &books)
+{
+  size_t sso = std::string().capacity();
+  size_t result = 0;
+  for(auto it = books.begin(); it != books.end(); it++)
+    {
+      for(const std::string *s :
+          { &it->book_path, &it->book_author, &it->book_name,
+            &it->book_series, &it->book_genre, &it->book_date })
+        {
+          if(s->size() > sso)
+            {
+              result++;
+            }
+        }
+    }
+  return result;
+}
+
+static std::string
+zipEntry(const std::string &data)
+{
+  // Local file header with deflated data, which is enough for
+  // ZipIndex::inflatedData().
+  std::string result(30, '\0');
+  result[0] = 'P';
+  result[1] = 'K';
+  result[2] = 3;
+  result[3] = 4;
+  result[8] = 8;
+  z_stream strm{};
+  deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8,
+               Z_DEFAULT_STRATEGY);
+  std::string comp(deflateBound(&strm, data.size()), '\0');
+  strm.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+  strm.avail_in = static_cast<uInt>(data.size());
+  strm.next_out = reinterpret_cast<Bytef *>(comp.data());
+  strm.avail_out = static_cast<uInt>(comp.size());
+  deflate(&strm, Z_FINISH);
+  comp.resize(strm.total_out);
+  deflateEnd(&strm);
+  return result + comp;
+}
+
+int
+main(int argc, char **argv)
+{
+  std::string inp;
+  if(argc > 1)
+    {
+      std::ifstream f(argv[1], std::ios_base::binary);
+      inp.assign(std::istreambuf_iterator<char>(f),
+                 std::istreambuf_iterator<char>());
+      if(inp.empty())
+        {
+          std::cout << "parse_bench: cannot read " << argv[1] << std::endl;
+          return 1;
+        }
+    }
+  else
+    {
+      inp = syntheticInp(200000);
+    }
+
+  InpParser parser;
+  std::vector<BookParseEntry> books;
+  std::vector<BookMeta> meta;
+  for(int i = 0; i < 3; i++)
+    {
+      books.clear();
+      books.shrink_to_fit();
+      meta.clear();
+      meta.shrink_to_fit();
+      size_t before = allocations;
+      auto start = std::chrono::steady_clock::now();
+      parser.parseChunk(inp, 0, inp.size(), books, meta, [] {
+        return false;
+      });
+      double elapsed = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+      size_t allocs = allocations - before;
+      size_t stored = storedStrings(books);
+      // Two allocations are made for reservation of record vectors.
+      double n = static_cast<double>(books.size());
+      std::cout << "parse: " << books.size() << " records, "
+                << n / elapsed / 1e6 << " M records/s, "
+                << static_cast<double>(allocs) / n << " allocations/record, "
+                << (static_cast<double>(allocs) - stored - 2) / n
+                << " besides stored strings" << std::endl;
+    }
+
+  std::string zip = zipEntry(inp);
+  std::string buf;
+  size_t allocs = 0;
+  auto start = std::chrono::steady_clock::now();
+  for(int i = 0; i < 10; i++)
+    {
+      size_t before = allocations;
+      if(!ZipIndex::inflatedData(zip, 0, zip.size() - 30, inp.size(), buf)
+         || buf != inp)
+        {
+          std::cout << "inflate: error" << std::endl;
+          return 1;
+        }
+      if(i > 0)
+        {
+          allocs += allocations - before;
+        }
+    }
+  double elapsed = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  std::cout << "inflate: " << static_cast<double>(inp.size()) * 10 / elapsed
+                                  / 1048576.0
+            << " MiB/s, " << allocs
+            << " buffer allocations after first .inp file" << std::endl;
+
+  return 0;
+}
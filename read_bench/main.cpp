@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <ReadEngine.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Compares pread and io_uring engines of ReadEngine.
+// Usage: read_bench [-t threads] [-q depth,depth...] [-w] file...
+// Every file is read by every engine and queue depth, files are shared
+// between threads, every thread reuses one engine like import does. Pages of
+// files are dropped from page cache before every pass (only clean pages can
+// be dropped), -w keeps them to measure reading from memory.
+
+static void
+dropCache(const std::vector<std::filesystem::path> &files)
+{
+#ifdef __linux
+  for(auto it = files.begin(); it != files.end(); it++)
+    {
+      int fd = ::open(it->c_str(), O_RDONLY | O_CLOEXEC);
+      if(fd >= 0)
+        {
+          posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+          ::close(fd);
+        }
+    }
+#endif
+}
+
+static bool
+pass(const std::vector<std::filesystem::path> &files, const int &type,
+     const unsigned &depth, const int &threads, int &real_type,
+     double &bytes)
+{
+  std::atomic<size_t> next(0);
+  std::atomic<uint64_t> total(0);
+  std::atomic<bool> error(false);
+  std::atomic<int> used_type(type);
+  std::vector<std::thread> thrs;
+  for(int i = 0; i < threads; i++)
+    {
+      thrs.emplace_back([&] {
+        ReadEngine re(type, depth);
+        if(re.engineType() != type)
+          {
+            used_type.store(re.engineType());
+          }
+        std::string buf;
+        for(size_t n = next.fetch_add(1); n < files.size();
+            n = next.fetch_add(1))
+          {
+            if(!re.readFile(files[n], buf, [] {
+                 return false;
+               }))
+              {
+                error.store(true);
+                break;
+              }
+            total.fetch_add(buf.size());
+          }
+      });
+    }
+  for(auto it = thrs.begin(); it != thrs.end(); it++)
+    {
+      it->join();
+    }
+  real_type = used_type.load();
+  bytes = static_cast<double>(total.load());
+  return !error.load();
+}
+
+int
+main(int argc, char **argv)
+{
+  int threads = 1;
+  std::vector<unsigned> depths = { 1, 4, 16, 64 };
+  bool warm = false;
+  std::vector<std::filesystem::path> files;
+  for(int i = 1; i < argc; i++)
+    {
+      std::string arg = argv[i];
+      if(arg == "-t" && i + 1 < argc)
+        {
+          threads = std::max(std::atoi(argv[++i]), 1);
+        }
+      else if(arg == "-q" && i + 1 < argc)
+        {
+          depths.clear();
+          std::string list = argv[++i];
+          for(std::string::size_type beg = 0; beg < list.size();)
+            {
+              std::string::size_type end = list.find(",", beg);
+              if(end == std::string::npos)
+                {
+                  end = list.size();
+                }
+              int val = std::atoi(list.substr(beg, end - beg).c_str());
+              if(val > 0)
+                {
+                  depths.push_back(static_cast<unsigned>(val));
+                }
+              beg = end + 1;
+            }
+        }
+      else if(arg == "-w")
+        {
+          warm = true;
+        }
+      else
+        {
+          files.push_back(std::filesystem::u8path(arg));
+        }
+    }
+  if(files.empty() || depths.empty())
+    {
+      std::cout << "Usage: read_bench [-t threads] [-q depth,depth...] [-w] "
+                   "file..."
+                << std::endl;
+      return 1;
+    }
+
+  std::cout << "engine\tdepth\tthreads\tMiB/s" << std::endl;
+  std::vector<std::pair<int, unsigned>> runs;
+  runs.emplace_back(ReadEngine::Pread, 1);
+  for(auto it = depths.begin(); it != depths.end(); it++)
+    {
+      runs.emplace_back(ReadEngine::IoUring, *it);
+    }
+  for(auto it = runs.begin(); it != runs.end(); it++)
+    {
+      if(!warm)
+        {
+          dropCache(files);
+        }
+      int real_type;
+      double bytes;
+      auto start = std::chrono::steady_clock::now();
+      if(!pass(files, it->first, it->second, threads, real_type, bytes))
+        {
+          std::cout << "read_bench: read error" << std::endl;
+          return 1;
+        }
+      double elapsed = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+      std::cout << (real_type == ReadEngine::IoUring ? "io_uring" : "pread")
+                << "\t" << (real_type == ReadEngine::IoUring ? it->second : 1)
+                << "\t" << threads << "\t"
+                << bytes / 1048576.0 / elapsed << std::endl;
+      if(it->first == ReadEngine::IoUring && real_type != it->first)
+        {
+          std::cout << "read_bench: io_uring is not available" << std::endl;
+          break;
+        }
+    }
+
+  return 0;
+}
@@ -0,0 +1,289 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <BaseIndex.h>
+#include <BookMeta.h>
+#include <ByteOrder.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+BaseIndex::BaseIndex(const int &search_keys)
+{
+  this->search_keys = search_keys;
+}
+
+void
+BaseIndex::addEntry(const FileParseEntry &fpe, const uint64_t &entry_offset)
+{
+  // See CollectionProcess::baseEntry() for entry layout.
+  uint64_t offset = entry_offset + sizeof(uint16_t) + fpe.file_rel_path.size()
+                    + sizeof(uint16_t) + fpe.file_hash.size();
+  for(auto it = fpe.books.begin(); it != fpe.books.end(); it++)
+    {
+      addValues(authors, it->book_author, offset);
+      addValues(genres, it->book_genre, offset);
+      std::string nm = seriesName(it->book_series);
+      if(!nm.empty())
+        {
+          series[nm].push_back(offset);
+        }
+      if(search_keys != ImportOptions::NoKeys && !it->book_name.empty())
+        {
+          titles[it->book_name].push_back(offset);
+        }
+
+      offset += sizeof(uint64_t) + 6 * sizeof(uint16_t)
+                + it->book_path.size() + it->book_author.size()
+                + it->book_name.size() + it->book_series.size()
+                + it->book_genre.size() + it->book_date.size();
+    }
+}
+
+bool
+BaseIndex::write(const std::filesystem::path &coll_path)
+{
+  bool result
+      = writeIndex(coll_path / std::filesystem::u8path("authors.idx"),
+                   authors);
+  result = writeIndex(coll_path / std::filesystem::u8path("genres.idx"),
+                      genres)
+           && result;
+  result = writeIndex(coll_path / std::filesystem::u8path("series.idx"),
+                      series)
+           && result;
+  if(search_keys != ImportOptions::NoKeys)
+    {
+      result = writeSearchKeys(coll_path
+                               / std::filesystem::u8path("search_keys"))
+               && result;
+    }
+  else
+    {
+      std::error_code ec;
+      std::filesystem::remove(
+          coll_path / std::filesystem::u8path("search_keys"), ec);
+    }
+  return result;
+}
+
+void
+BaseIndex::addValues(
+    std::unordered_map<std::string, std::vector<uint64_t>> &index,
+    const std::string &values, const uint64_t &offset)
+{
+  // Authors and genres are separated by ", " in base.
+  std::string sep = ", ";
+  std::string::size_type n_beg = 0;
+  while(n_beg < values.size())
+    {
+      std::string::size_type n_end = values.find(sep, n_beg);
+      if(n_end == std::string::npos)
+        {
+          n_end = values.size();
+        }
+      if(n_end > n_beg)
+        {
+          std::vector<uint64_t> &offsets
+              = index[values.substr(n_beg, n_end - n_beg)];
+          // The same value can be repeated in one record.
+          if(offsets.empty() || offsets.back() != offset)
+            {
+              offsets.push_back(offset);
+            }
+        }
+      n_beg = n_end + sep.size();
+    }
+}
+
+std::string
+BaseIndex::seriesName(const std::string &series)
+{
+  return series.substr(0, series.find(series_number_separator));
+}
+
+bool
+BaseIndex::writeIndex(
+    const std::filesystem::path &index_path,
+    const std::unordered_map<std::string, std::vector<uint64_t>> &index)
+{
+  std::vector<const std::string *> keys;
+  keys.reserve(index.size());
+  for(auto it = index.begin(); it != index.end(); it++)
+    {
+      keys.push_back(&it->first);
+    }
+  std::sort(keys.begin(), keys.end(),
+            [](const std::string *el1, const std::string *el2) {
+              return *el1 < *el2;
+            });
+
+  std::filesystem::path tmp = index_path;
+  tmp += std::filesystem::u8path(".new");
+  std::fstream f;
+  f.open(tmp, std::ios_base::out | std::ios_base::binary);
+  if(!f.is_open())
+    {
+      std::cout << "BaseIndex::writeIndex error: cannot open " << tmp
+                << std::endl;
+      return false;
+    }
+
+  ByteOrder bo;
+  uint16_t val16;
+  uint64_t val64;
+  std::string buf = "MLIDX";
+  buf.push_back(1);
+  val64 = static_cast<uint64_t>(keys.size());
+  bo = val64;
+  bo.get_little(val64);
+  buf.append(reinterpret_cast<char *>(&val64), sizeof(val64));
+  for(auto it = keys.begin(); it != keys.end(); it++)
+    {
+      const std::string &key = *(*it);
+      val16 = static_cast<uint16_t>(key.size());
+      bo = val16;
+      bo.get_little(val16);
+      buf.append(reinterpret_cast<char *>(&val16), sizeof(val16));
+      buf += key;
+
+      const std::vector<uint64_t> &offsets = index.at(key);
+      val64 = static_cast<uint64_t>(offsets.size());
+      bo = val64;
+      bo.get_little(val64);
+      buf.append(reinterpret_cast<char *>(&val64), sizeof(val64));
+      for(auto it_o = offsets.begin(); it_o != offsets.end(); it_o++)
+        {
+          val64 = *it_o;
+          bo = val64;
+          bo.get_little(val64);
+          buf.append(reinterpret_cast<char *>(&val64), sizeof(val64));
+        }
+
+      if(buf.size() > 1048576)
+        {
+          f.write(buf.c_str(), buf.size());
+          buf.clear();
+        }
+    }
+  f.write(buf.c_str(), buf.size());
+  f.close();
+
+  std::error_code ec;
+  std::filesystem::rename(tmp, index_path, ec);
+  if(ec)
+    {
+      std::cout << "BaseIndex::writeIndex error: " << ec.message()
+                << std::endl;
+      return false;
+    }
+  return true;
+}
+
+bool
+BaseIndex::writeSearchKeys(const std::filesystem::path &keys_path)
+{
+  std::filesystem::path tmp = keys_path;
+  tmp += std::filesystem::u8path(".new");
+  std::fstream f;
+  f.open(tmp, std::ios_base::out | std::ios_base::binary);
+  if(!f.is_open())
+    {
+      std::cout << "BaseIndex::writeSearchKeys error: cannot open " << tmp
+                << std::endl;
+      return false;
+    }
+
+  bool transliterate = search_keys == ImportOptions::LatinKeys;
+  TextFolder folder(transliterate);
+  std::string buf = "MLSK";
+  buf.push_back(1);
+  buf.push_back(transliterate ? 1 : 0);
+  addSection(f, buf, folder, authors);
+  addSection(f, buf, folder, titles);
+  addSection(f, buf, folder, series);
+  f.write(buf.c_str(), buf.size());
+  f.close();
+
+  std::error_code ec;
+  std::filesystem::rename(tmp, keys_path, ec);
+  if(ec)
+    {
+      std::cout << "BaseIndex::writeSearchKeys error: " << ec.message()
+                << std::endl;
+      return false;
+    }
+  return true;
+}
+
+void
+BaseIndex::addSection(
+    std::fstream &f, std::string &buf, const TextFolder &folder,
+    const std::unordered_map<std::string, std::vector<uint64_t>> &index)
+{
+  // Every unique value is normalized once.
+  typedef std::pair<const std::string, std::vector<uint64_t>> IndexValue;
+  std::vector<std::pair<std::string, const IndexValue *>> keys;
+  keys.reserve(index.size());
+  for(auto it = index.begin(); it != index.end(); it++)
+    {
+      keys.emplace_back(folder.fold(it->first), &(*it));
+    }
+  std::sort(keys.begin(), keys.end(),
+            [](const std::pair<std::string, const IndexValue *> &el1,
+               const std::pair<std::string, const IndexValue *> &el2) {
+              if(el1.first != el2.first)
+                {
+                  return el1.first < el2.first;
+                }
+              return el1.second->first < el2.second->first;
+            });
+
+  ByteOrder bo;
+  uint16_t val16;
+  uint64_t val64;
+  auto add_str = [&buf, &bo, &val16](const std::string &str) {
+    val16 = static_cast<uint16_t>(str.size());
+    bo = val16;
+    bo.get_little(val16);
+    buf.append(reinterpret_cast<char *>(&val16), sizeof(val16));
+    buf += str;
+  };
+  auto add_64 = [&buf, &bo, &val64](const uint64_t &val) {
+    val64 = val;
+    bo = val64;
+    bo.get_little(val64);
+    buf.append(reinterpret_cast<char *>(&val64), sizeof(val64));
+  };
+
+  add_64(static_cast<uint64_t>(keys.size()));
+  for(auto it = keys.begin(); it != keys.end(); it++)
+    {
+      add_str(it->first);
+      add_str(it->second->first);
+      const std::vector<uint64_t> &offsets = it->second->second;
+      add_64(static_cast<uint64_t>(offsets.size()));
+      for(auto it_o = offsets.begin(); it_o != offsets.end(); it_o++)
+        {
+          add_64(*it_o);
+        }
+
+      if(buf.size() > 1048576)
+        {
+          f.write(buf.c_str(), buf.size());
+          buf.clear();
+        }
+    }
+}
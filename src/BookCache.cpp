@@ -0,0 +1,449 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <ArchEntry.h>
+#include <BookCache.h>
+#include <ByteOrder.h>
+#include <Fb2Parser.h>
+#include <LibArchive.h>
+#include <algorithm>
+#include <cctype>
+#include <gtkmm-4.0/gdkmm/pixbufloader.h>
+#include <iostream>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+BookCache::BookCache(const std::shared_ptr<AuxFunc> &af)
+{
+  this->af = af;
+#ifdef USE_OPENMP
+  omp_init_lock(&blob_mtx);
+#endif
+}
+
+BookCache::~BookCache()
+{
+  // Cache is removed if it has not been closed (operation was canceled).
+  if(blob.is_open())
+    {
+      blob.close();
+      std::error_code ec;
+      std::filesystem::remove(
+          coll_path / std::filesystem::u8path("book_cache.new"), ec);
+    }
+#ifdef USE_OPENMP
+  omp_destroy_lock(&blob_mtx);
+#endif
+}
+
+bool
+BookCache::open(const std::filesystem::path &coll_path)
+{
+  this->coll_path = coll_path;
+  blob.open(coll_path / std::filesystem::u8path("book_cache.new"),
+            std::ios_base::out | std::ios_base::binary);
+  if(!blob.is_open())
+    {
+      std::cout << "BookCache::open error: cannot open cache in " << coll_path
+                << std::endl;
+      return false;
+    }
+  blob_size = 0;
+  entries.clear();
+  pending.clear();
+  next_seq = 0;
+  return true;
+}
+
+bool
+BookCache::addArchive(const std::filesystem::path &arch_path,
+                      const FileParseEntry &fpe, const size_t &seq,
+                      const std::function<bool()> &canceled)
+{
+  LibArchive la(af);
+  std::vector<ArchEntry> arch_entries;
+  la.fileNames(arch_path, arch_entries);
+  std::unordered_map<std::string, size_t> arch_ind;
+  arch_ind.reserve(arch_entries.size());
+  for(size_t i = 0; i < arch_entries.size(); i++)
+    {
+      arch_ind.emplace(arch_entries[i].filename, i);
+    }
+
+  std::vector<BookCachePending> books;
+  std::string ext = ".fb2";
+  for(auto it = fpe.books.begin(); it != fpe.books.end(); it++)
+    {
+      if(canceled())
+        {
+          return false;
+        }
+      if(it->book_path.size() < ext.size()
+         || !std::equal(ext.begin(), ext.end(),
+                        it->book_path.end() - ext.size(),
+                        [](const char &el1, const char &el2) {
+                          return el1
+                                 == std::tolower(
+                                     static_cast<unsigned char>(el2));
+                        }))
+        {
+          continue;
+        }
+      auto it_a = arch_ind.find(it->book_path);
+      if(it_a == arch_ind.end())
+        {
+          continue;
+        }
+
+      std::string book
+          = la.unpackByPositionStr(arch_path, arch_entries[it_a->second]);
+      BookCachePending pb;
+      if(bookData(book, pb))
+        {
+          pb.bce.arch_path = fpe.file_rel_path;
+          pb.bce.book_path = it->book_path;
+          books.emplace_back(std::move(pb));
+        }
+    }
+  commit(seq, std::move(books));
+  return true;
+}
+
+bool
+BookCache::close(const std::vector<FileParseEntry> &base)
+{
+  if(!blob.is_open())
+    {
+      return false;
+    }
+  blob.close();
+
+  std::sort(entries.begin(), entries.end(),
+            [](const BookCacheEntry &el1, const BookCacheEntry &el2) {
+              if(el1.arch_path == el2.arch_path)
+                {
+                  return el1.book_path < el2.book_path;
+                }
+              return el1.arch_path < el2.arch_path;
+            });
+
+  // Books removed from base as duplicates are not indexed, their data stays
+  // in book_cache unused.
+  std::unordered_map<std::string_view, const FileParseEntry *> archives;
+  archives.reserve(base.size());
+  for(auto it = base.begin(); it != base.end(); it++)
+    {
+      archives.emplace(it->file_rel_path, &(*it));
+    }
+  std::unordered_set<std::string_view> books;
+  std::string arch_path;
+  size_t kept = 0;
+  for(size_t i = 0; i < entries.size(); i++)
+    {
+      if(i == 0 || entries[i].arch_path != arch_path)
+        {
+          arch_path = entries[i].arch_path;
+          books.clear();
+          auto it_a = archives.find(arch_path);
+          if(it_a != archives.end())
+            {
+              for(auto it = it_a->second->books.begin();
+                  it != it_a->second->books.end(); it++)
+                {
+                  books.insert(it->book_path);
+                }
+            }
+        }
+      if(books.find(entries[i].book_path) != books.end())
+        {
+          if(kept != i)
+            {
+              entries[kept] = std::move(entries[i]);
+            }
+          kept++;
+        }
+    }
+  entries.resize(kept);
+
+  std::filesystem::path idx_tmp
+      = coll_path / std::filesystem::u8path("book_cache.idx.new");
+  std::fstream f;
+  f.open(idx_tmp, std::ios_base::out | std::ios_base::binary);
+  if(!f.is_open())
+    {
+      std::cout << "BookCache::close error: cannot open " << idx_tmp
+                << std::endl;
+      return false;
+    }
+
+  ByteOrder bo;
+  std::string buf = "MLBC";
+  buf.push_back(2);
+  auto add_str = [&buf, &bo](const std::string &str) {
+    uint16_t val16 = static_cast<uint16_t>(str.size());
+    bo = val16;
+    bo.get_little(val16);
+    buf.append(reinterpret_cast<char *>(&val16), sizeof(val16));
+    buf += str;
+  };
+  auto add_64 = [&buf, &bo](uint64_t val64) {
+    bo = val64;
+    bo.get_little(val64);
+    buf.append(reinterpret_cast<char *>(&val64), sizeof(val64));
+  };
+  add_64(static_cast<uint64_t>(entries.size()));
+  for(auto it = entries.begin(); it != entries.end(); it++)
+    {
+      add_str(it->arch_path);
+      add_str(it->book_path);
+      add_64(it->annotation_offset);
+      add_64(it->annotation_size);
+      add_64(it->cover_offset);
+      add_64(it->cover_size);
+      add_str(it->cover_type);
+    }
+  f.write(buf.c_str(), buf.size());
+  f.close();
+
+  std::error_code ec;
+  std::filesystem::rename(
+      coll_path / std::filesystem::u8path("book_cache.new"),
+      coll_path / std::filesystem::u8path("book_cache"), ec);
+  if(!ec)
+    {
+      std::filesystem::rename(
+          idx_tmp, coll_path / std::filesystem::u8path("book_cache.idx"), ec);
+    }
+  if(ec)
+    {
+      std::cout << "BookCache::close error: " << ec.message() << std::endl;
+      return false;
+    }
+  return true;
+}
+
+bool
+BookCache::bookData(const std::string &book, BookCachePending &pb)
+{
+  BookCacheEntry &bce = pb.bce;
+  std::string &annotation = pb.annotation;
+  std::string &cover = pb.cover;
+  std::string::size_type desc_end = book.find("</description>");
+  if(desc_end == std::string::npos)
+    {
+      return false;
+    }
+
+  Fb2Parser parser;
+  std::string::size_type n = 0;
+  annotation = parser.tagContent(book, "annotation", n, desc_end);
+  if(!annotation.empty())
+    {
+      // Books declared as windows-1251 and similar are not UTF-8.
+      parser.toUtf8(book, annotation);
+    }
+
+  n = 0;
+  std::string coverpage = parser.tagContent(book, "coverpage", n, desc_end);
+  std::string::size_type n_img = coverpage.find("<image");
+  std::string id;
+  if(n_img != std::string::npos)
+    {
+      id = parser.attribute(
+          coverpage.substr(n_img, coverpage.find(">", n_img) - n_img),
+          "href");
+    }
+  if(!id.empty() && id[0] == '#')
+    {
+      id.erase(id.begin());
+    }
+
+  std::string::size_type n_bin = desc_end;
+  while(!id.empty())
+    {
+      n_bin = book.find("<binary", n_bin);
+      if(n_bin == std::string::npos)
+        {
+          break;
+        }
+      std::string::size_type n_tag_end = book.find(">", n_bin);
+      if(n_tag_end == std::string::npos)
+        {
+          break;
+        }
+      std::string tag = book.substr(n_bin, n_tag_end - n_bin);
+      n_bin = n_tag_end + 1;
+      if(parser.attribute(tag, "id") != id)
+        {
+          continue;
+        }
+      std::string::size_type n_end = book.find("</binary>", n_bin);
+      if(n_end == std::string::npos)
+        {
+          break;
+        }
+      cover = base64Decode(book, n_bin, n_end);
+      if(!cover.empty())
+        {
+          bce.cover_type = parser.attribute(tag, "content-type");
+          thumbnail(cover, bce.cover_type);
+        }
+      break;
+    }
+
+  return !annotation.empty() || !cover.empty();
+}
+
+bool
+BookCache::thumbnail(std::string &cover, std::string &cover_type)
+{
+  try
+    {
+      Glib::RefPtr<Gdk::PixbufLoader> loader = Gdk::PixbufLoader::create();
+      loader->write(reinterpret_cast<const guint8 *>(cover.c_str()),
+                    cover.size());
+      loader->close();
+      Glib::RefPtr<Gdk::Pixbuf> image = loader->get_pixbuf();
+      if(!image)
+        {
+          return false;
+        }
+      int width = image->get_width();
+      int height = image->get_height();
+      if(width <= thumbnail_size && height <= thumbnail_size)
+        {
+          return true;
+        }
+      if(width > height)
+        {
+          height = std::max(height * thumbnail_size / width, 1);
+          width = thumbnail_size;
+        }
+      else
+        {
+          width = std::max(width * thumbnail_size / height, 1);
+          height = thumbnail_size;
+        }
+      image = image->scale_simple(width, height, Gdk::InterpType::BILINEAR);
+
+      std::string type = image->get_has_alpha() ? "png" : "jpeg";
+      gchar *buf = nullptr;
+      gsize buf_sz = 0;
+      image->save_to_buffer(buf, buf_sz, type);
+      cover.assign(buf, buf_sz);
+      g_free(buf);
+      cover_type = "image/" + type;
+    }
+  catch(Glib::Error &er)
+    {
+      // Cover is kept as is.
+      std::cout << "BookCache::thumbnail error: " << er.what() << std::endl;
+      return false;
+    }
+  return true;
+}
+
+std::string
+BookCache::base64Decode(const std::string &str, std::string::size_type beg,
+                        std::string::size_type end)
+{
+  std::string result;
+  result.reserve((end - beg) / 4 * 3);
+  uint32_t acc = 0;
+  int bits = 0;
+  for(; beg < end; beg++)
+    {
+      char ch = str[beg];
+      uint32_t val;
+      if(ch >= 'A' && ch <= 'Z')
+        {
+          val = ch - 'A';
+        }
+      else if(ch >= 'a' && ch <= 'z')
+        {
+          val = ch - 'a' + 26;
+        }
+      else if(ch >= '0' && ch <= '9')
+        {
+          val = ch - '0' + 52;
+        }
+      else if(ch == '+')
+        {
+          val = 62;
+        }
+      else if(ch == '/')
+        {
+          val = 63;
+        }
+      else if(ch == '=')
+        {
+          break;
+        }
+      else
+        {
+          // Line breaks and other whitespaces.
+          continue;
+        }
+      acc = (acc << 6) | val;
+      bits += 6;
+      if(bits >= 8)
+        {
+          bits -= 8;
+          result.push_back(static_cast<char>((acc >> bits) & 0xFF));
+        }
+    }
+  return result;
+}
+
+void
+BookCache::commit(const size_t &seq, std::vector<BookCachePending> &&books)
+{
+#ifndef USE_OPENMP
+  std::lock_guard<std::mutex> lglock(blob_mtx);
+#endif
+#ifdef USE_OPENMP
+  omp_set_lock(&blob_mtx);
+#endif
+  pending.emplace(seq, std::move(books));
+  for(auto it = pending.begin();
+      it != pending.end() && it->first == next_seq;
+      it = pending.erase(it))
+    {
+      for(auto it_b = it->second.begin(); it_b != it->second.end(); it_b++)
+        {
+          append(*it_b);
+        }
+      next_seq++;
+    }
+#ifdef USE_OPENMP
+  omp_unset_lock(&blob_mtx);
+#endif
+}
+
+void
+BookCache::append(BookCachePending &pb)
+{
+  BookCacheEntry &bce = pb.bce;
+  bce.annotation_offset = blob_size;
+  bce.annotation_size = static_cast<uint64_t>(pb.annotation.size());
+  blob.write(pb.annotation.c_str(), pb.annotation.size());
+  blob_size += bce.annotation_size;
+  bce.cover_offset = blob_size;
+  bce.cover_size = static_cast<uint64_t>(pb.cover.size());
+  blob.write(pb.cover.c_str(), pb.cover.size());
+  blob_size += bce.cover_size;
+  entries.emplace_back(std::move(bce));
+}
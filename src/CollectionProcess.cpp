@@ -13,19 +13,43 @@
  * You should have received a copy of the GNU General Public License along with
  * this program. If not, see <https://www.gnu.org/licenses/>.
  */
+#include <BaseIndex.h>
+#include <BookCache.h>
 #include <ByteOrder.h>
 #include <CollectionProcess.h>
+#include <DeviceQueues.h>
+#include <DirScanner.h>
+#include <Fb2Parser.h>
+#include <InpEncoding.h>
+#include <InpParser.h>
+#include <IndexReader.h>
+#include <InpxCache.h>
 #include <LibArchive.h>
+#include <ReadEngine.h>
 #include <SelfRemovingPath.h>
+#include <SqliteExport.h>
+#include <ThreadPriority.h>
+#include <TraceRecorder.h>
+#include <ZipIndex.h>
 #include <algorithm>
+#include <cctype>
+#include <chrono>
 #include <cstring>
 #include <fstream>
 #include <iostream>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 
 #ifndef USE_OPENMP
 #include <thread>
 #endif
 
+#ifdef __linux
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 CollectionProcess::CollectionProcess(const std::shared_ptr<AuxFunc> &af,
                                      const int &thr_num)
 {
@@ -34,735 +58,2415 @@ CollectionProcess::CollectionProcess(const std::shared_ptr<AuxFunc> &af,
   hsh = new Hasher(af);
 #ifndef USE_OPENMP
   cancel.store(false);
+  active_inp.store(0);
   parsed_bytes.store(0.0);
 #endif
-#ifdef USE_OPENMP
-  omp_init_lock(&base_mtx);
-#endif
 }
 
 CollectionProcess::~CollectionProcess()
-{  
+{
   delete hsh;
-#ifdef USE_OPENMP
-  omp_destroy_lock(&base_mtx);
-#endif
+  delete dup_index;
+  delete book_cache;
+  delete rate_limiter;
+  delete read_pool;
+  delete trace;
 }
 
 void
-CollectionProcess::collectFiles(const std::filesystem::path &inpx_path,
-                                const std::filesystem::path &books_path,
+CollectionProcess::collectFiles(const std::vector<ImportSource> &sources,
                                 const std::string &coll_name)
 {
-  this->books_path = books_path;
   this->coll_name = coll_name;
-  this->inpx_path = inpx_path;
-  LibArchive la(af);
-  la.fileNames(inpx_path, books_entries_list);
 
-  for(auto it = books_entries_list.begin(); it != books_entries_list.end();)
+  // Books directories of sources with equal .inpx file are searched as one
+  // set of roots in order of sources.
+  std::vector<std::filesystem::path> inpx_list;
+  std::vector<std::vector<std::filesystem::path>> roots_list;
+  for(auto it = sources.begin(); it != sources.end(); it++)
     {
-#ifndef USE_OPENMP
-      if(cancel.load())
+      auto it_i
+          = std::find(inpx_list.begin(), inpx_list.end(), it->inpx_path);
+      if(it_i == inpx_list.end())
         {
-          break;
+          inpx_list.push_back(it->inpx_path);
+          roots_list.emplace_back();
+          it_i = inpx_list.end() - 1;
         }
-#endif
-#ifdef USE_OPENMP
-      bool cncl;
-#pragma omp atomic read
-      cncl = cancel;
-      if(cncl)
+      roots_list[std::distance(inpx_list.begin(), it_i)].push_back(
+          it->books_path);
+    }
+
+  // Archive is orphan only if no .inp file of any source matches it, so
+  // orphans are added after all sources.
+  std::unordered_map<std::string, std::filesystem::path> orphans;
+  for(size_t i = 0; i < inpx_list.size(); i++)
+    {
+      if(interrupted())
         {
           break;
         }
-#endif
-      std::filesystem::path p = std::filesystem::u8path(it->filename);
-      if(p.extension().u8string() == ".inp")
+      if(!addSource(inpx_list[i], roots_list[i], orphans))
         {
-          std::filesystem::path bfp;
-          std::error_code ec;
-          for(auto &pp : std::filesystem::directory_iterator(books_path, ec))
-            {
-              if(pp.path().stem() == p.stem())
-                {
-                  bfp = pp;
-                  break;
-                }
-            }
-          if(ec)
-            {
-              std::cout << "CollectionProcess::collectFiles " << ec.message()
-                        << std::endl;
-              books_entries_list.clear();
-              break;
-            }
-          if(bfp.empty())
-            {
-              books_entries_list.erase(it);
-              continue;
-            }
-          uintmax_t sz = std::filesystem::file_size(bfp, ec);
-          if(ec)
-            {
-              std::cout << "CollectionProcess::collectFiles " << bfp << " "
-                        << ec.message() << std::endl;
-              books_entries_list.erase(it);
-            }
-          else
-            {
-              total_size += static_cast<double>(sz);
-              it++;
-            }
+          books_entries_list.clear();
+          orphans.clear();
+          break;
         }
-      else
+    }
+  if(options.import_orphans)
+    {
+      for(auto it = books_entries_list.begin();
+          it != books_entries_list.end(); it++)
         {
-          it++;
+          orphans.erase(it->arch_path.u8string());
         }
+      addOrphans(orphans);
+    }
+  books_path = commonPath(sources);
+  if(books_path.empty() && !sources.empty())
+    {
+      // Relative paths of base are taken from common directory of all
+      // books directories (e.g. directories on different Windows drives
+      // have none).
+      std::cout << "CollectionProcess::collectFiles error: books "
+                   "directories have no common root"
+                << std::endl;
+      books_entries_list.clear();
+      total_size = 0.0;
     }
 }
 
-void
-CollectionProcess::createBase()
+bool
+CollectionProcess::addSource(
+    const std::filesystem::path &inpx_path,
+    const std::vector<std::filesystem::path> &roots,
+    std::unordered_map<std::string, std::filesystem::path> &orphans)
 {
-#ifndef USE_OPENMP
-  for(auto it = books_entries_list.begin(); it != books_entries_list.end();
-      it++)
+  std::vector<std::filesystem::path> abs_roots;
+  for(auto it = roots.begin(); it != roots.end(); it++)
     {
-      if(cancel.load())
+      std::error_code ec;
+      std::filesystem::path p
+          = std::filesystem::absolute(*it, ec).lexically_normal();
+      if(ec || !std::filesystem::is_directory(p, ec))
         {
-          break;
+          std::cout << "CollectionProcess::addSource error: " << p << " "
+                    << ec.message() << std::endl;
+          return false;
         }
-      ArchEntry ent = *it;
-      std::unique_lock<std::mutex> ullock(run_thr_mtx);
-      run_thr++;
-      std::thread thr([this, ent] {
-        FileParseEntry fpe;
-        std::filesystem::path p = std::filesystem::u8path(ent.filename);
-        std::error_code ec;
-        std::filesystem::path found_p;
-        for(auto &pp : std::filesystem::directory_iterator(books_path, ec))
-          {
-            if(pp.path().stem() == p.stem())
-              {
-                found_p = pp.path();
-                break;
-              }
-          }
-        if(ec)
-          {
-            std::cout << "CollectionProcess::createBase error: "
-                      << ec.message() << std::endl;
-            cancel.store(true);
-            std::lock_guard<std::mutex> lglock(run_thr_mtx);
-            run_thr--;
-            run_thr_var.notify_all();
-            return void();
-          }
-        if(found_p.empty())
-          {
-            std::lock_guard<std::mutex> lglock(run_thr_mtx);
-            run_thr--;
-            run_thr_var.notify_all();
-            return void();
-          }
-        fpe.file_rel_path = found_p.filename().u8string();
-        p = found_p;
-
-        double sz = static_cast<double>(std::filesystem::file_size(p, ec));
-        if(ec)
-          {
-            std::cout << "CollectionProcess::createBase error: "
-                      << ec.message() << std::endl;
-          }
-        else
-          {
-            std::thread thr([this, p, &fpe] {
-              fpe.file_hash = hsh->file_hashing(p);
-            });
-
-            parseInp(inpx_path, ent, fpe);
-
-            thr.join();
+      abs_roots.emplace_back(std::move(p));
+    }
 
-            base_mtx.lock();
-            base.emplace_back(fpe);
-            base_mtx.unlock();
-          }
+  std::error_code ec;
+  std::unordered_map<std::string, std::filesystem::path> archives;
+  DirScanner scanner(thr_num);
+  if(!scanner.scan(abs_roots, archives,
+                   std::bind(&CollectionProcess::interrupted, this)))
+    {
+      return false;
+    }
 
-        parsed_bytes.store(parsed_bytes.load() + sz);
-        if(signal_progress)
-          {
-            signal_progress(parsed_bytes.load(), total_size);
-          }
-        std::lock_guard<std::mutex> lglock(run_thr_mtx);
-        run_thr--;
-        run_thr_var.notify_all();
-      });
-      thr.detach();
+  std::vector<ArchEntry> inpx_entries;
+  LibArchive la(af);
+  la.fileNames(inpx_path, inpx_entries);
 
-      run_thr_var.wait(ullock, [this] {
-        return run_thr < thr_num;
-      });
+  // CRC-32 values of .inp files are used to find changed entries on update.
+  ZipIndex inpx_index;
+  inpx_index.readCentralDirectory(inpx_path);
+  std::vector<std::string> matched;
+  if(!inpx_index.stored.empty() || !inpx_index.deflated.empty())
+    {
+      std::shared_ptr<MappedFile> mf = std::make_shared<MappedFile>();
+      if(mf->open(inpx_path))
+        {
+          inpx_maps[inpx_path.u8string()] = mf;
+        }
     }
 
-  std::unique_lock<std::mutex> ullock(run_thr_mtx);
-  run_thr_var.wait(ullock, [this] {
-    return run_thr == 0;
-  });
-#endif
+  // Parsed .inp files are taken from cache while .inpx file is unchanged.
+  std::shared_ptr<InpxCache> cache = std::make_shared<InpxCache>();
+  std::filesystem::path cache_dir = af->homePath();
+  cache_dir /= std::filesystem::u8path(".cache/MyLibrary/MLInpxPlugin");
+  cache->open(cache_dir, hsh->file_hashing(inpx_path));
+  inpx_caches[inpx_path.u8string()] = cache;
 
-#ifdef USE_OPENMP
-  omp_set_num_threads(thr_num);
-  omp_set_dynamic(true);
-  int lvls = omp_get_max_active_levels();
-  omp_set_max_active_levels(omp_get_supported_active_levels());
-#pragma omp parallel
-#pragma omp for
-  for(auto it = books_entries_list.begin(); it != books_entries_list.end();
-      it++)
+  for(auto it = inpx_entries.begin(); it != inpx_entries.end(); it++)
     {
-      bool cncl;
-#pragma omp atomic read
-      cncl = cancel;
-      if(cncl)
+      if(interrupted())
+        {
+          break;
+        }
+      std::filesystem::path p = std::filesystem::u8path(it->filename);
+      if(p.extension().u8string() != ".inp")
         {
-#pragma omp cancel for
           continue;
         }
-      ArchEntry ent = *it;
-      FileParseEntry fpe;
-      std::filesystem::path p = std::filesystem::u8path(ent.filename);
-      std::error_code ec;
-      std::filesystem::path found_p;
-      for(auto &pp : std::filesystem::directory_iterator(books_path, ec))
+      auto it_a = archives.find(p.stem().u8string());
+      if(it_a == archives.end())
         {
-          if(pp.path().stem() == p.stem())
-            {
-              found_p = pp.path();
-              break;
-            }
+          unmatched_inp++;
+          continue;
         }
+      uintmax_t sz = std::filesystem::file_size(it_a->second, ec);
       if(ec)
         {
-          std::cout << "CollectionProcess::createBase error: " << ec.message()
-                    << std::endl;
-#pragma omp atomic write
-          cancel = true;
-#pragma omp cancel for
+          std::cout << "CollectionProcess::addSource " << it_a->second << " "
+                    << ec.message() << std::endl;
           continue;
         }
-      if(found_p.empty())
+      InpEntry ie;
+      ie.entry = *it;
+      ie.inpx_path = inpx_path;
+      ie.arch_path = it_a->second;
+      ie.arch_size = static_cast<double>(sz);
+      ie.arch_mtime = std::filesystem::last_write_time(it_a->second, ec);
+      ie.inp_crc_known = inpx_index.crc32(it->filename, ie.inp_crc);
+      ie.inp_stored = inpx_index.storedEntry(it->filename, ie.inp_offset,
+                                             ie.inp_size);
+      if(!ie.inp_stored)
         {
-          continue;
+          ie.inp_deflated = inpx_index.deflatedEntry(
+              it->filename, ie.inp_offset, ie.inp_comp_size, ie.inp_size);
         }
-      fpe.file_rel_path = found_p.filename().u8string();
-      p = found_p;
+      total_size += ie.arch_size;
+      books_entries_list.emplace_back(std::move(ie));
+      matched.push_back(it_a->first);
+    }
 
-      double sz = static_cast<double>(std::filesystem::file_size(p, ec));
-      if(ec)
+  if(options.import_orphans)
+    {
+      for(auto it = matched.begin(); it != matched.end(); it++)
         {
-          std::cout << "CollectionProcess::createBase error: " << ec.message()
-                    << std::endl;
+          archives.erase(*it);
         }
-      else
+      for(auto it = archives.begin(); it != archives.end(); it++)
         {
-#pragma omp parallel
-#pragma omp master
-          {
-#pragma omp masked
-            {
-              omp_event_handle_t event;
-#pragma omp task detach(event)
-              {
-                fpe.file_hash = hsh->file_hashing(p);
-                omp_fulfill_event(event);
-              }
-            }
+          orphans.emplace(it->second.u8string(), it->second);
+        }
+    }
 
-            parseInp(inpx_path, ent, fpe);
-#pragma omp taskwait
-          }
+  return true;
+}
 
-          omp_set_lock(&base_mtx);
-          base.emplace_back(fpe);
-          omp_unset_lock(&base_mtx);
+void
+CollectionProcess::addOrphans(
+    const std::unordered_map<std::string, std::filesystem::path> &archives)
+{
+  std::vector<std::string> ext = { ".zip", ".7z", ".rar" };
+  for(auto it = archives.begin(); it != archives.end(); it++)
+    {
+      std::string arch_ext = it->second.extension().u8string();
+      std::transform(arch_ext.begin(), arch_ext.end(), arch_ext.begin(),
+                     [](const char &el) {
+                       return std::tolower(static_cast<unsigned char>(el));
+                     });
+      std::error_code ec;
+      if(std::find(ext.begin(), ext.end(), arch_ext) == ext.end()
+         || !std::filesystem::is_regular_file(it->second, ec))
+        {
+          continue;
         }
-
-#pragma omp atomic capture
-      {
-        parsed_bytes += sz;
-        sz = parsed_bytes;
-      }
-      if(signal_progress)
+      uintmax_t sz = std::filesystem::file_size(it->second, ec);
+      if(ec)
         {
-          signal_progress(sz, total_size);
+          std::cout << "CollectionProcess::addOrphans " << it->second << " "
+                    << ec.message() << std::endl;
+          continue;
         }
+      InpEntry ie;
+      ie.orphan = true;
+      ie.arch_path = it->second;
+      ie.arch_size = static_cast<double>(sz);
+      ie.arch_mtime = std::filesystem::last_write_time(it->second, ec);
+      // Records of orphan archive depend on archive only, so .inp
+      // checksum is taken as known and empty for update.
+      ie.inp_crc_known = true;
+      total_size += ie.arch_size;
+      books_entries_list.emplace_back(std::move(ie));
     }
-  omp_set_dynamic(false);
-  omp_set_max_active_levels(lvls);
-#endif
+}
 
-  std::filesystem::path base_path = af->homePath();
-  base_path /= std::filesystem::u8path(".local/share/MyLibrary/Collections");
-  base_path /= std::filesystem::u8path(coll_name);
-  base_path /= std::filesystem::u8path("base");
-  std::filesystem::create_directories(base_path.parent_path());
-  std::fstream f;
-  f.open(base_path, std::ios_base::out | std::ios_base::binary);
-  if(f.is_open())
+std::filesystem::path
+CollectionProcess::commonPath(const std::vector<ImportSource> &sources)
+{
+  std::filesystem::path result;
+  for(auto it = sources.begin(); it != sources.end(); it++)
     {
-      std::string vl = books_path.u8string();
-      uint16_t val16 = static_cast<uint16_t>(vl.size());
-      ByteOrder bo = val16;
-      bo.get_little(val16);
-      size_t sz_16 = sizeof(val16);
-
-      f.write(reinterpret_cast<char *>(&val16), sz_16);
-      f.write(vl.c_str(), vl.size());
-
-      size_t sz;
-      uint64_t val64;
-      size_t sz_64 = sizeof(val64);
-      for(auto it = base.begin(); it != base.end(); it++)
+      std::error_code ec;
+      std::filesystem::path p
+          = std::filesystem::absolute(it->books_path, ec).lexically_normal();
+      if(p.filename().empty())
         {
-          std::string entry;
-
-          val16 = static_cast<uint16_t>(it->file_rel_path.size());
-          bo = val16;
-          bo.get_little(val16);
-
-          entry.resize(sz_16);
-          std::memcpy(&entry[0], &val16, sz_16);
-
-          entry += it->file_rel_path;
+          p = p.parent_path();
+        }
+      if(it == sources.begin())
+        {
+          result = p;
+          continue;
+        }
+      std::filesystem::path common;
+      auto it_r = result.begin();
+      auto it_p = p.begin();
+      while(it_r != result.end() && it_p != p.end() && *it_r == *it_p)
+        {
+          common /= *it_r;
+          it_r++;
+          it_p++;
+        }
+      result = common;
+    }
+  return result;
+}
 
-          val16 = static_cast<uint16_t>(it->file_hash.size());
-          bo = val16;
-          bo.get_little(val16);
-          sz = entry.size();
-          entry.resize(sz + sz_16);
-          std::memcpy(&entry[sz], &val16, sz_16);
+void
+CollectionProcess::createBase()
+{
+  importBase();
+}
 
-          entry += it->file_hash;
+bool
+CollectionProcess::importBase()
+{
+  if(books_path.empty())
+    {
+      return false;
+    }
+  std::filesystem::path coll_path = collectionPath();
+  std::filesystem::path marker
+      = coll_path / std::filesystem::u8path("import_incomplete");
 
-          for(auto it_b = it->books.begin(); it_b != it->books.end(); it_b++)
+  // Archives completely processed by interrupted import of the same
+  // collection are not hashed again.
+  if(std::filesystem::exists(marker))
+    {
+      CollectionState state;
+      if(state.read(coll_path / std::filesystem::u8path("import_state"))
+         && state.books_path == books_path)
+        {
+          for(auto it = books_entries_list.begin();
+              it != books_entries_list.end(); it++)
             {
-              std::string book_entry;
-              for(int i = 1; i <= 6; i++)
-                {
-                  switch(i)
-                    {
-                    case 1:
-                      {
-                        val16 = static_cast<uint16_t>(it_b->book_path.size());
-                        break;
-                      }
-                    case 2:
-                      {
-                        val16
-                            = static_cast<uint16_t>(it_b->book_author.size());
-                        break;
-                      }
-                    case 3:
-                      {
-                        val16 = static_cast<uint16_t>(it_b->book_name.size());
-                        break;
-                      }
-                    case 4:
-                      {
-                        val16
-                            = static_cast<uint16_t>(it_b->book_series.size());
-                        break;
-                      }
-                    case 5:
-                      {
-                        val16 = static_cast<uint16_t>(it_b->book_genre.size());
-                        break;
-                      }
-                    case 6:
-                      {
-                        val16 = static_cast<uint16_t>(it_b->book_date.size());
-                        break;
-                      }
-                    default:
-                      {
-                        break;
-                      }
-                    }
-                  bo = val16;
-                  bo.get_little(val16);
-                  sz = book_entry.size();
-                  book_entry.resize(sz + sz_16);
-                  std::memcpy(&book_entry[sz], &val16, sz_16);
-
-                  switch(i)
-                    {
-                    case 1:
-                      {
-                        book_entry += it_b->book_path;
-                        break;
-                      }
-                    case 2:
-                      {
-                        book_entry += it_b->book_author;
-                        break;
-                      }
-                    case 3:
-                      {
-                        book_entry += it_b->book_name;
-                        break;
-                      }
-                    case 4:
-                      {
-                        book_entry += it_b->book_series;
-                        break;
-                      }
-                    case 5:
-                      {
-                        book_entry += it_b->book_genre;
-                        break;
-                      }
-                    case 6:
-                      {
-                        book_entry += it_b->book_date;
-                        break;
-                      }
-                    default:
-                      break;
-                    }
-                }
+              state.unchangedArchive(
+                  it->arch_path.lexically_relative(books_path).u8string(),
+                  *it, it->file_hash);
+            }
+        }
+    }
 
-              val64 = static_cast<uint64_t>(book_entry.size());
-              bo = val64;
-              bo.get_little(val64);
-              sz = entry.size();
-              entry.resize(sz + sz_64);
-              std::memcpy(&entry[sz], &val64, sz_64);
+  startTrace();
+  dup_index = new DuplicateIndex;
+  // Annotations and covers are extracted by the same threads right after
+  // archive has been hashed, so archive is not read again.
+  if(options.extract_cache)
+    {
+      std::filesystem::create_directories(coll_path);
+      book_cache = new BookCache(af);
+      if(!book_cache->open(coll_path))
+        {
+          delete book_cache;
+          book_cache = nullptr;
+        }
+    }
+  {
+    TraceScope ts(trace, "process entries");
+    processEntries();
+  }
+  if(!interrupted())
+    {
+      saveInpxCaches();
+    }
 
-              entry += book_entry;
-            }
-          val64 = static_cast<uint64_t>(entry.size());
-          bo = val64;
-          bo.get_little(val64);
+  std::filesystem::create_directories(coll_path);
 
-          f.write(reinterpret_cast<char *>(&val64), sz_64);
-          f.write(entry.c_str(), entry.size());
+  if(interrupted())
+    {
+      // Base of interrupted import contains completely processed archives
+      // only. Marker lets import of this collection be started again.
+      delete dup_index;
+      dup_index = nullptr;
+      // Cache file is removed by BookCache destructor, if it was not closed.
+      delete book_cache;
+      book_cache = nullptr;
+      removeDuplicates();
+      if(writeBase(coll_path))
+        {
+          std::fstream f;
+          f.open(marker, std::ios_base::out | std::ios_base::binary);
+          f.close();
         }
+      finishTrace(coll_path);
+      return false;
+    }
 
-      f.close();
+  {
+    TraceScope ts(trace, "resolve duplicates");
+    size_t dups = dup_index->resolve();
+    if(dups > 0)
+      {
+        dup_index->writeReport(coll_path
+                               / std::filesystem::u8path("duplicates.txt"));
+        if(options.keep_newest_duplicate)
+          {
+            dups = dup_index->removeOlder(base);
+            std::cout << "CollectionProcess::createBase: " << dups
+                      << " older duplicates removed" << std::endl;
+          }
+      }
+    delete dup_index;
+    dup_index = nullptr;
+  }
+
+  removeDuplicates();
+
+  if(!writeBase(coll_path))
+    {
+      // Cache file is removed by BookCache destructor.
+      delete book_cache;
+      book_cache = nullptr;
+      finishTrace(coll_path);
+      return false;
     }
-}
+  std::error_code ec;
+  std::filesystem::remove(marker, ec);
 
-void
-CollectionProcess::stopAll()
-{
-#ifndef USE_OPENMP
-  cancel.store(true);
-#endif
-#ifdef USE_OPENMP
-#pragma omp atomic write
-  cancel = true;
-#endif
-  if(hsh)
+  if(book_cache)
     {
-      hsh->cancelAll();
+      TraceScope ts(trace, "cache");
+      book_cache->close(base);
+      delete book_cache;
+      book_cache = nullptr;
     }
+  finishTrace(coll_path);
+
+  return true;
 }
 
-void
-CollectionProcess::parseInp(const std::filesystem::path &arch_path,
-                            const ArchEntry &e, FileParseEntry &fpe)
+bool
+CollectionProcess::updateBase()
 {
-  std::filesystem::path p
-      = af->temp_path() / std::filesystem::u8path(af->randomFileName());
-  SelfRemovingPath srp(p);
+  if(books_path.empty())
+    {
+      return false;
+    }
+  std::filesystem::path coll_path = collectionPath();
 
-  LibArchive la(af);
-  std::filesystem::path inp_p = la.unpackByPosition(arch_path, srp.path, e);
+  CollectionState state;
+  std::vector<FileParseEntry> old_base;
+  if(state.read(coll_path / std::filesystem::u8path("import_state"))
+     && state.books_path == books_path)
+    {
+      std::filesystem::path old_books_path;
+      std::unordered_map<uint64_t, size_t> series_names;
+      readSeriesNames(coll_path / std::filesystem::u8path("series.idx"),
+                      series_names);
+      readBase(coll_path / std::filesystem::u8path("base"), old_books_path,
+               old_base, &series_names);
+    }
+  else
+    {
+      state.archives.clear();
+    }
+  size_t old_sz = old_base.size();
 
-  std::fstream f;
-  f.open(inp_p, std::ios_base::in | std::ios_base::binary);
-  if(f.is_open())
+  std::unordered_map<std::string, size_t> old_ind;
+  old_ind.reserve(old_base.size());
+  for(size_t i = 0; i < old_base.size(); i++)
     {
-      std::string fl_str;
-      f.seekg(0, std::ios_base::end);
-      fl_str.resize(f.tellg());
-      f.seekg(0, std::ios_base::beg);
-      f.read(fl_str.data(), fl_str.size());
-      f.close();
+      old_ind.emplace(old_base[i].file_rel_path, i);
+    }
 
-      std::string find_str = { 0x0d, 0x0a };
-      std::string::size_type n_beg = 0;
-      std::string::size_type n_end = 0;
-      for(;;)
+  // Entries with unchanged archive and unchanged .inp file are taken from
+  // existing base. Archives with unchanged size and modification time are
+  // not hashed again.
+  std::vector<InpEntry> unchanged;
+  std::vector<InpEntry> changed;
+  total_size = 0.0;
+  for(auto it = books_entries_list.begin(); it != books_entries_list.end();
+      it++)
+    {
+      std::string rel_path
+          = it->arch_path.lexically_relative(books_path).u8string();
+      auto it_o = old_ind.find(rel_path);
+      if(it_o == old_ind.end())
         {
-#ifndef USE_OPENMP
-          if(cancel.load())
+          state.unchangedArchive(rel_path, *it, it->file_hash);
+        }
+      else
+        {
+          size_t ind = it_o->second;
+          old_ind.erase(it_o);
+          if(state.unchangedArchive(rel_path, *it, it->file_hash)
+             && state.unchangedInp(rel_path, *it))
             {
-              break;
+              base.emplace_back(std::move(old_base[ind]));
+              unchanged.emplace_back(std::move(*it));
+              continue;
             }
-#endif
-#ifdef USE_OPENMP
-          bool cncl;
-#pragma omp atomic read
-          cncl = cancel;
-          if(cncl)
-            {
-              break;
-            }
-#endif
-          n_end = fl_str.find(find_str, n_beg);
-          if(n_end != std::string::npos)
-            {
-              std::string ent(fl_str.begin() + n_beg, fl_str.begin() + n_end);
-              parseEntry(ent, fpe);
-            }
-          else
+        }
+      total_size += it->arch_size;
+      changed.emplace_back(std::move(*it));
+    }
+  old_base.clear();
+
+  std::cout << "CollectionProcess::updateBase: " << changed.size()
+            << " changed archives, " << old_ind.size()
+            << " archives removed from base" << std::endl;
+  if(changed.empty() && base.size() == old_sz)
+    {
+      return false;
+    }
+
+  // Duplicates are searched among records of all archives and book cache is
+  // made of all archives, so with these options collection is imported
+  // again. Hash sums of archives with unchanged size and modification time
+  // have been set above, these archives are not hashed again.
+  if(options.keep_newest_duplicate || options.extract_cache)
+    {
+      base.clear();
+      books_entries_list = std::move(unchanged);
+      for(auto it = books_entries_list.begin();
+          it != books_entries_list.end(); it++)
+        {
+          total_size += it->arch_size;
+        }
+      books_entries_list.insert(books_entries_list.end(),
+                                std::make_move_iterator(changed.begin()),
+                                std::make_move_iterator(changed.end()));
+      return importBase();
+    }
+
+  books_entries_list = std::move(changed);
+  startTrace();
+  {
+    TraceScope ts(trace, "process entries");
+    processEntries();
+  }
+  if(interrupted())
+    {
+      finishTrace(coll_path);
+      return false;
+    }
+  saveInpxCaches();
+
+  removeDuplicates();
+
+  books_entries_list.insert(books_entries_list.end(),
+                            std::make_move_iterator(unchanged.begin()),
+                            std::make_move_iterator(unchanged.end()));
+  if(!writeBase(coll_path))
+    {
+      finishTrace(coll_path);
+      return false;
+    }
+  // Update completes base of interrupted import too.
+  std::error_code ec;
+  std::filesystem::remove(
+      coll_path / std::filesystem::u8path("import_incomplete"), ec);
+  finishTrace(coll_path);
+
+  return true;
+}
+
+void
+CollectionProcess::verifyBase(const std::string &coll_name,
+                              VerifyReport &report)
+{
+  this->coll_name = coll_name;
+  std::filesystem::path coll_path = collectionPath();
+
+  std::vector<FileParseEntry> old_base;
+  if(!readBase(coll_path / std::filesystem::u8path("base"), books_path,
+               old_base))
+    {
+      std::cout << "CollectionProcess::verifyBase error: cannot read base of "
+                << coll_name << std::endl;
+      return void();
+    }
+
+  // Archives merged with equal ones on import are present in import state
+  // only.
+  std::unordered_map<std::string, std::string> known;
+  for(auto it = old_base.begin(); it != old_base.end(); it++)
+    {
+      known.emplace(it->file_rel_path, it->file_hash);
+    }
+  old_base.clear();
+  CollectionState state;
+  if(state.read(coll_path / std::filesystem::u8path("import_state"))
+     && state.books_path == books_path)
+    {
+      for(auto it = state.archives.begin(); it != state.archives.end(); it++)
+        {
+          known.emplace(it->first, it->second.file_hash);
+        }
+    }
+
+  std::unordered_set<std::string> dirs;
+  books_entries_list.clear();
+  total_size = 0.0;
+  for(auto it = known.begin(); it != known.end(); it++)
+    {
+      InpEntry ie;
+      ie.arch_path = books_path / std::filesystem::u8path(it->first);
+      ie.file_hash = it->second;
+      dirs.insert(ie.arch_path.parent_path().u8string());
+      std::error_code ec;
+      uintmax_t sz = std::filesystem::file_size(ie.arch_path, ec);
+      if(ec)
+        {
+          report.missing.push_back(it->first);
+          continue;
+        }
+      ie.arch_size = static_cast<double>(sz);
+      total_size += ie.arch_size;
+      books_entries_list.emplace_back(std::move(ie));
+    }
+
+  for(auto it = dirs.begin(); it != dirs.end(); it++)
+    {
+      std::error_code ec;
+      for(auto &pp : std::filesystem::directory_iterator(
+               std::filesystem::u8path(*it), ec))
+        {
+          if(!pp.is_regular_file())
             {
-              break;
+              continue;
             }
-          n_beg = n_end + find_str.size();
-          if(n_beg >= fl_str.size())
+          std::string rel_path
+              = pp.path().lexically_relative(books_path).u8string();
+          if(known.find(rel_path) == known.end())
             {
-              break;
+              report.extra.push_back(rel_path);
             }
         }
     }
+
+  std::chrono::time_point<std::chrono::steady_clock> start
+      = std::chrono::steady_clock::now();
+
+  createReadPool();
+#ifndef USE_OPENMP
+  std::mutex report_mtx;
+  std::atomic<size_t> next_entry;
+  next_entry.store(0);
+  std::vector<std::thread> workers;
+  workers.reserve(thr_num);
+  for(int i = 0; i < thr_num; i++)
+    {
+      workers.emplace_back(std::thread([this, &report, &report_mtx,
+                                        &next_entry] {
+        ThreadPriority tp(options);
+        for(;;)
+          {
+            size_t n = next_entry.fetch_add(1);
+            if(n >= books_entries_list.size() || !verifyArchive(n))
+              {
+                break;
+              }
+            std::lock_guard<std::mutex> lglock(report_mtx);
+            report.checked++;
+            if(books_entries_list[n].file_hash.empty())
+              {
+                report.mismatched.push_back(
+                    books_entries_list[n]
+                        .arch_path.lexically_relative(books_path)
+                        .u8string());
+              }
+          }
+      }));
+    }
+  for(auto it = workers.begin(); it != workers.end(); it++)
+    {
+      it->join();
+    }
+#endif
+#ifdef USE_OPENMP
+  omp_set_num_threads(thr_num);
+  int n_entries = static_cast<int>(books_entries_list.size());
+#pragma omp parallel
+#pragma omp for
+  for(int i = 0; i < n_entries; i++)
+    {
+      // "omp cancel for" has no effect without OMP_CANCELLATION set, so
+      // remaining iterations are skipped explicitly.
+      if(interrupted())
+        {
+#pragma omp cancel for
+          continue;
+        }
+      ThreadPriority tp(options);
+      if(!verifyArchive(static_cast<size_t>(i)))
+        {
+#pragma omp cancel for
+          continue;
+        }
+#pragma omp critical
+      {
+        report.checked++;
+        if(books_entries_list[i].file_hash.empty())
+          {
+            report.mismatched.push_back(
+                books_entries_list[i]
+                    .arch_path.lexically_relative(books_path)
+                    .u8string());
+          }
+      }
+    }
+#endif
+
+  delete read_pool;
+  read_pool = nullptr;
+
+  report.elapsed_time = std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+#ifndef USE_OPENMP
+  report.bytes_hashed = parsed_bytes.load();
+#endif
+#ifdef USE_OPENMP
+#pragma omp atomic read
+  report.bytes_hashed = parsed_bytes;
+#endif
+
+  std::sort(report.mismatched.begin(), report.mismatched.end());
+  std::sort(report.missing.begin(), report.missing.end());
+  std::sort(report.extra.begin(), report.extra.end());
+
+  std::fstream f;
+  f.open(coll_path / std::filesystem::u8path("verify.txt"),
+         std::ios_base::out | std::ios_base::binary);
+  if(f.is_open())
+    {
+      for(auto it = report.mismatched.begin(); it != report.mismatched.end();
+          it++)
+        {
+          f << "MISMATCHED " << *it << "\n";
+        }
+      for(auto it = report.missing.begin(); it != report.missing.end(); it++)
+        {
+          f << "MISSING " << *it << "\n";
+        }
+      for(auto it = report.extra.begin(); it != report.extra.end(); it++)
+        {
+          f << "EXTRA " << *it << "\n";
+        }
+      f.close();
+    }
+}
+
+bool
+CollectionProcess::verifyArchive(const size_t &n)
+{
+  if(interrupted())
+    {
+      return false;
+    }
+  InpEntry &ie = books_entries_list[n];
+  if(rate_limiter && !rate_limiter->acquire(ie.arch_size, [this] {
+       return interrupted();
+     }))
+    {
+      return false;
+    }
+  std::string hash = hashArchive(ie.arch_path);
+  if(interrupted())
+    {
+      return false;
+    }
+  // Empty hash marks mismatched archive for caller.
+  if(hash != ie.file_hash)
+    {
+      ie.file_hash.clear();
+    }
+
+  double sz = ie.arch_size;
+#ifndef USE_OPENMP
+  parsed_bytes.store(parsed_bytes.load() + sz);
+  sz = parsed_bytes.load();
+#endif
+#ifdef USE_OPENMP
+#pragma omp atomic capture
+  {
+    parsed_bytes += sz;
+    sz = parsed_bytes;
+  }
+#endif
+  if(signal_progress)
+    {
+      signal_progress(sz, total_size);
+    }
+  return true;
 }
 
 void
-CollectionProcess::parseEntry(const std::string &ent, FileParseEntry &fpe)
+CollectionProcess::setRateLimit(const double &bytes_per_sec)
 {
-  BookParseEntry bpe;
-  std::string::size_type n_beg = 0;
-  std::string::size_type n_end = 0;
-  std::string find_str = { 0x04 };
-  for(int i = 1; i <= 11; i++)
+  delete rate_limiter;
+  rate_limiter = nullptr;
+  if(bytes_per_sec > 0.0)
     {
-      n_end = ent.find(find_str, n_beg);
-      if(n_end != std::string::npos)
-        {
-          switch(i)
-            {
-            case 1:
-              {
-                bpe.book_author
-                    = std::string(ent.begin() + n_beg, ent.begin() + n_end);
-                bpe.book_author.erase(std::remove_if(bpe.book_author.begin(),
-                                                     bpe.book_author.end(),
-                                                     [](char &el) {
-                                                       if(el >= 0 && el <= 32)
-                                                         {
-                                                           return true;
-                                                         }
-                                                       else
-                                                         {
-                                                           return false;
-                                                         }
-                                                     }),
-                                      bpe.book_author.end());
-                if(bpe.book_author.size() > 0)
-                  {
-                    if(*bpe.book_author.rbegin() == ':')
-                      {
-                        bpe.book_author.pop_back();
-                      }
-                  }
+      rate_limiter = new RateLimiter(bytes_per_sec);
+    }
+}
 
-                std::string insert = ", ";
-                for(auto it = bpe.book_author.begin();
-                    it != bpe.book_author.end();)
-                  {
-                    switch(*it)
-                      {
-                      case ',':
-                        {
-                          *it = ' ';
-                          it++;
-                          break;
-                        }
-                      case ':':
-                        {
-                          it = bpe.book_author.erase(it);
-                          it = bpe.book_author.insert(it, insert.begin(),
-                                                      insert.end());
-                          it++;
-                          it++;
-                          break;
-                        }
-                      default:
-                        {
-                          it++;
-                          break;
-                        }
-                      }
-                  }
-                std::string::size_type n = 0;
-                std::string f_str = " ,";
-                while(bpe.book_author.size() > 0)
-                  {
-                    n = bpe.book_author.find(f_str, n);
-                    if(n != std::string::npos)
-                      {
-                        bpe.book_author.erase(bpe.book_author.begin() + n);
-                      }
-                    else
-                      {
-                        break;
-                      }
-                  }
+void
+CollectionProcess::processEntries()
+{
+  std::vector<std::vector<FileParseEntry>> shards;
+  // Archives are given to threads in order of base, so book cache, which is
+  // written in this order, keeps few finished archives in memory.
+  std::vector<std::pair<std::string, size_t>> order;
+  order.reserve(books_entries_list.size());
+  for(size_t i = 0; i < books_entries_list.size(); i++)
+    {
+      order.emplace_back(books_entries_list[i]
+                             .arch_path.lexically_relative(books_path)
+                             .u8string(),
+                         i);
+    }
+  std::sort(order.begin(), order.end());
+  DeviceQueues queues(options.device_threads);
+  for(size_t i = 0; i < order.size(); i++)
+    {
+      InpEntry &ie = books_entries_list[order[i].second];
+      ie.base_order = i;
+      queues.add(order[i].second, ie.arch_path);
+    }
+  order.clear();
+  createReadPool();
+#ifndef USE_OPENMP
+  shards.resize(thr_num);
+  std::vector<std::thread> workers;
+  workers.reserve(thr_num);
+  for(int i = 0; i < thr_num; i++)
+    {
+      workers.emplace_back(std::thread([this, &shards, &queues, i] {
+        ThreadPriority tp(options);
+        std::vector<FileParseEntry> &shard = shards[i];
+        for(;;)
+          {
+            if(cancel.load())
+              {
+                break;
+              }
+            size_t n;
+            size_t q;
+            {
+              TraceScope ts(trace, "wait disk");
+              if(!queues.next(n, q, [this] {
+                   return interrupted();
+                 }))
+                {
+                  break;
+                }
+            }
+            InpEntry &ie = books_entries_list[n];
+            {
+              TraceScope ts(trace, "wait thread");
+              if(scheduler && !scheduler->acquireThread([this] {
+                   return interrupted();
+                 }))
+                {
+                  queues.release(q);
+                  break;
+                }
+            }
+            TraceScope ts(trace, "archive", ie.arch_path.u8string());
 
-                while(bpe.book_author.size() > 0)
+            FileParseEntry fpe;
+            fpe.file_rel_path
+                = ie.arch_path.lexically_relative(books_path).u8string();
+            std::filesystem::path p = ie.arch_path;
+            // Device slot is released as soon as archive and its .inp file
+            // have been read: parsing and search of duplicates do not use
+            // disk.
+            std::atomic<int> io_left(1);
+            auto io_done = [&queues, &io_left, q] {
+              if(io_left.fetch_sub(1) == 1)
+                {
+                  queues.release(q);
+                }
+            };
+            std::thread thr;
+            int hash_thr = 0;
+            if(ie.file_hash.empty())
+              {
+                hash_thr = takeThreads(2);
+                if(hash_thr > 0)
                   {
-                    char ch = *bpe.book_author.begin();
-                    if(ch >= 0 && ch <= 32)
-                      {
-                        bpe.book_author.erase(bpe.book_author.begin());
-                      }
-                    else
-                      {
-                        break;
-                      }
+                    io_left.fetch_add(1);
+                    thr = std::thread([this, p, &fpe, &io_done] {
+                      ThreadPriority tp(options);
+                      fpe.file_hash = hashArchive(p);
+                      io_done();
+                    });
                   }
-                while(bpe.book_author.size() > 0)
+                else
                   {
-                    char ch = *bpe.book_author.rbegin();
-                    if(ch >= 0 && ch <= 32)
-                      {
-                        bpe.book_author.pop_back();
-                      }
-                    else
-                      {
-                        break;
-                      }
+                    // Scheduler has no free thread for hashing, so archive
+                    // is hashed in the same thread.
+                    fpe.file_hash = hashArchive(p);
                   }
-                break;
               }
-            case 2:
+            else
               {
-                bpe.book_genre
-                    = std::string(ent.begin() + n_beg, ent.begin() + n_end);
-                bpe.book_genre.erase(std::remove_if(bpe.book_genre.begin(),
-                                                    bpe.book_genre.end(),
-                                                    [](char &el) {
-                                                      if(el >= 0 && el <= 32)
-                                                        {
-                                                          return true;
-                                                        }
-                                                      else
-                                                        {
-                                                          return false;
-                                                        }
-                                                    }),
-                                     bpe.book_genre.end());
-                if(bpe.book_genre.size() > 0)
-                  {
-                    if(*bpe.book_genre.rbegin() == ':')
-                      {
-                        bpe.book_genre.pop_back();
-                      }
-                  }
+                fpe.file_hash = ie.file_hash;
+              }
 
-                std::string insert = ", ";
-                for(auto it = bpe.book_genre.begin();
-                    it != bpe.book_genre.end();)
-                  {
-                    switch(*it)
-                      {
-                      case ',':
-                        {
-                          *it = ' ';
-                          it++;
-                          break;
-                        }
-                      case ':':
-                        {
-                          it = bpe.book_genre.erase(it);
-                          it = bpe.book_genre.insert(it, insert.begin(),
-                                                     insert.end());
-                          it++;
-                          it++;
-                          break;
-                        }
-                      default:
-                        {
-                          it++;
-                          break;
-                        }
-                      }
-                  }
-                std::string::size_type n = 0;
-                std::string f_str = " ,";
-                while(bpe.book_genre.size() > 0)
-                  {
-                    n = bpe.book_genre.find(f_str, n);
-                    if(n != std::string::npos)
-                      {
-                        bpe.book_genre.erase(bpe.book_genre.begin() + n);
-                      }
-                    else
-                      {
-                        break;
-                      }
-                  }
-                break;
+            ZipIndex zi;
+            bool zi_read = zi.readCentralDirectory(p);
+            std::vector<BookMeta> meta;
+            bool inp_read = false;
+            auto inp_done = [&inp_read, &io_done] {
+              if(!inp_read)
+                {
+                  inp_read = true;
+                  io_done();
+                }
+            };
+            parseInp(ie, fpe, meta, inp_done);
+            inp_done();
+            if(zi_read)
+              {
+                checkBooks(zi, p, fpe, meta);
               }
-            case 3:
+            if(book_cache && !ie.orphan)
               {
-                bpe.book_name
-                    = std::string(ent.begin() + n_beg, ent.begin() + n_end);
-                break;
+                TraceScope ts(trace, "book cache");
+                book_cache->addArchive(p, fpe, ie.base_order, [this] {
+                  return interrupted();
+                });
               }
-            case 4:
+            if(dup_index)
               {
-                bpe.book_series
-                    = std::string(ent.begin() + n_beg, ent.begin() + n_end);
-                break;
+                TraceScope ts(trace, "duplicates");
+                dup_index->addArchive(fpe, meta, ie.inpx_path.u8string());
               }
-            case 5:
+
+            if(thr.joinable())
               {
-                std::string s_nm(ent.begin() + n_beg, ent.begin() + n_end);
-                if(!s_nm.empty())
-                  {
-                    bpe.book_series += " " + s_nm;
-                  }
-                break;
+                TraceScope ts(trace, "wait hash");
+                thr.join();
               }
-            case 6:
+            if(scheduler)
               {
-                bpe.book_path
-                    = std::string(ent.begin() + n_beg, ent.begin() + n_end);
-                break;
+                scheduler->releaseThreads(hash_thr);
+                scheduler->releaseThread();
               }
-            case 10:
+            // Hashing or parsing could be stopped in the middle of archive,
+            // so it is not kept.
+            if(cancel.load())
               {
-                std::string ext(ent.begin() + n_beg, ent.begin() + n_end);
-                if(!ext.empty())
-                  {
-                    bpe.book_path += "." + ext;
-                  }
                 break;
               }
-            case 11:
+            ie.file_hash = fpe.file_hash;
+
+            shard.emplace_back(std::move(fpe));
+
+            parsed_bytes.store(parsed_bytes.load() + ie.arch_size);
+            if(signal_progress)
               {
-                bpe.book_date
-                    = std::string(ent.begin() + n_beg, ent.begin() + n_end);
-                break;
+                signal_progress(parsed_bytes.load(), total_size);
               }
-            default:
-              break;
-            }
+          }
+      }));
+    }
+  for(auto it = workers.begin(); it != workers.end(); it++)
+    {
+      it->join();
+    }
+#endif
+
+#ifdef USE_OPENMP
+  omp_set_num_threads(thr_num);
+  omp_set_dynamic(true);
+  int lvls = omp_get_max_active_levels();
+  omp_set_max_active_levels(omp_get_supported_active_levels());
+  shards.resize(omp_get_max_threads());
+  int n_entries = static_cast<int>(books_entries_list.size());
+  // Every iteration takes next archive from disk queues, so iterations are
+  // given to threads one by one.
+#pragma omp parallel
+#pragma omp for schedule(dynamic)
+  for(int i = 0; i < n_entries; i++)
+    {
+      bool cncl;
+#pragma omp atomic read
+      cncl = cancel;
+      if(cncl)
+        {
+#pragma omp cancel for
+          continue;
         }
-      else
+      // OpenMP threads are reused, so priority is lowered for every archive
+      // and restored after it.
+      ThreadPriority tp(options);
+      size_t n;
+      size_t q;
+      {
+        TraceScope ts(trace, "wait disk");
+        if(!queues.next(n, q, [this] {
+             return interrupted();
+           }))
+          {
+            continue;
+          }
+      }
+      InpEntry &ie = books_entries_list[n];
+      {
+        TraceScope ts(trace, "wait thread");
+        if(scheduler && !scheduler->acquireThread([this] {
+             return interrupted();
+           }))
+          {
+            queues.release(q);
+            continue;
+          }
+      }
+      TraceScope ts(trace, "archive", ie.arch_path.u8string());
+
+      FileParseEntry fpe;
+      fpe.file_rel_path
+          = ie.arch_path.lexically_relative(books_path).u8string();
+      std::filesystem::path p = ie.arch_path;
+      // Device slot is released as soon as archive and its .inp file have
+      // been read: parsing and search of duplicates do not use disk.
+      int io_left = 1;
+      auto io_done = [&queues, &io_left, q] {
+        int left;
+#pragma omp atomic capture
+        left = --io_left;
+        if(left == 0)
+          {
+            queues.release(q);
+          }
+      };
+      int hash_thr = 0;
+      if(ie.file_hash.empty())
         {
-          break;
+          hash_thr = takeThreads(2);
+          if(hash_thr > 0)
+            {
+              io_left++;
+            }
+          else
+            {
+              // Scheduler has no free thread for hashing, so archive is
+              // hashed in the same thread.
+              fpe.file_hash = hashArchive(p);
+            }
         }
-      n_beg = n_end + find_str.size();
-      if(n_beg >= ent.size())
+      else
         {
-          break;
+          fpe.file_hash = ie.file_hash;
         }
-    }
-  fpe.books.emplace_back(bpe);
-}
+#pragma omp parallel num_threads(hash_thr + 1)
+#pragma omp master
+      {
+        if(hash_thr > 0)
+          {
+#pragma omp masked
+            {
+              omp_event_handle_t event;
+#pragma omp task detach(event)
+              {
+                ThreadPriority tp(options);
+                fpe.file_hash = hashArchive(p);
+                io_done();
+                omp_fulfill_event(event);
+              }
+            }
+          }
+
+        ZipIndex zi;
+        bool zi_read = zi.readCentralDirectory(p);
+        std::vector<BookMeta> meta;
+        bool inp_read = false;
+        auto inp_done = [&inp_read, &io_done] {
+          if(!inp_read)
+            {
+              inp_read = true;
+              io_done();
+            }
+        };
+        parseInp(ie, fpe, meta, inp_done);
+        inp_done();
+        if(zi_read)
+          {
+            checkBooks(zi, p, fpe, meta);
+          }
+        if(book_cache && !ie.orphan)
+          {
+            TraceScope ts(trace, "book cache");
+            book_cache->addArchive(p, fpe, ie.base_order, [this] {
+              return interrupted();
+            });
+          }
+        if(dup_index)
+          {
+            TraceScope ts(trace, "duplicates");
+            dup_index->addArchive(fpe, meta, ie.inpx_path.u8string());
+          }
+        TraceScope ts(trace, "wait hash");
+#pragma omp taskwait
+      }
+      if(scheduler)
+        {
+          scheduler->releaseThreads(hash_thr);
+          scheduler->releaseThread();
+        }
+      // Hashing or parsing could be stopped in the middle of archive, so it
+      // is not kept.
+#pragma omp atomic read
+      cncl = cancel;
+      if(cncl)
+        {
+          continue;
+        }
+      ie.file_hash = fpe.file_hash;
+
+      shards[omp_get_thread_num()].emplace_back(std::move(fpe));
+
+      double sz = ie.arch_size;
+#pragma omp atomic capture
+      {
+        parsed_bytes += sz;
+        sz = parsed_bytes;
+      }
+      if(signal_progress)
+        {
+          signal_progress(sz, total_size);
+        }
+    }
+  omp_set_dynamic(false);
+  omp_set_max_active_levels(lvls);
+#endif
+  delete read_pool;
+  read_pool = nullptr;
+
+  size_t base_sz = 0;
+  for(auto it = shards.begin(); it != shards.end(); it++)
+    {
+      base_sz += it->size();
+    }
+  base.reserve(base_sz);
+  for(auto it = shards.begin(); it != shards.end(); it++)
+    {
+      base.insert(base.end(), std::make_move_iterator(it->begin()),
+                  std::make_move_iterator(it->end()));
+    }
+  shards.clear();
+
+  // Order of shards depends on threads, so archives are sorted by path.
+  // Base (and files made from it) is the same for any number of threads,
+  // and update gives the same base as new import. Whole base is sorted once
+  // instead of reordering results in a bounded window: records of all
+  // archives are kept in memory until base is written anyway.
+  std::sort(base.begin(), base.end(),
+            [](const FileParseEntry &el1, const FileParseEntry &el2) {
+              return el1.file_rel_path < el2.file_rel_path;
+            });
+}
+
+bool
+CollectionProcess::writeBase(const std::filesystem::path &coll_path)
+{
+  TraceScope ts(trace, "write base");
+  // Base is written to temporary file first and then renamed, so MyLibrary
+  // never sees partially written base.
+  std::filesystem::path base_path
+      = coll_path / std::filesystem::u8path("base");
+  std::filesystem::path tmp_path
+      = coll_path / std::filesystem::u8path("base.new");
+  std::fstream f;
+  f.open(tmp_path, std::ios_base::out | std::ios_base::binary);
+  if(f.is_open())
+    {
+      std::string vl = books_path.u8string();
+      uint16_t val16 = static_cast<uint16_t>(vl.size());
+      ByteOrder bo = val16;
+      bo.get_little(val16);
+      size_t sz_16 = sizeof(val16);
+
+      f.write(reinterpret_cast<char *>(&val16), sz_16);
+      f.write(vl.c_str(), vl.size());
+
+      uint64_t val64;
+      size_t sz_64 = sizeof(val64);
+      BaseIndex index(options.search_keys);
+      uint64_t offset = static_cast<uint64_t>(sz_16 + vl.size());
+      for(auto it = base.begin(); it != base.end(); it++)
+        {
+          std::string entry = baseEntry(*it);
+          index.addEntry(*it, offset + sz_64);
+          offset += static_cast<uint64_t>(sz_64 + entry.size());
+
+          val64 = static_cast<uint64_t>(entry.size());
+          bo = val64;
+          bo.get_little(val64);
+
+          f.write(reinterpret_cast<char *>(&val64), sz_64);
+          f.write(entry.c_str(), entry.size());
+        }
+
+      bool written = f.good();
+      f.close();
+      std::error_code ec;
+      if(!written || f.fail())
+        {
+          // Short write (full disk, for example): existing base is kept.
+          std::cout << "CollectionProcess::writeBase error: cannot write "
+                    << tmp_path << std::endl;
+          std::filesystem::remove(tmp_path, ec);
+          return false;
+        }
+
+      std::filesystem::rename(tmp_path, base_path, ec);
+      if(ec)
+        {
+          std::cout << "CollectionProcess::writeBase error: " << ec.message()
+                    << std::endl;
+          return false;
+        }
+
+      index.write(coll_path);
+
+      if(options.export_sqlite)
+        {
+          SqliteExport sql_export;
+          sql_export.write(
+              coll_path / std::filesystem::u8path("catalog.sqlite"),
+              books_path, base);
+        }
+
+      CollectionState state;
+      state.write(coll_path / std::filesystem::u8path("import_state"),
+                  books_path, books_entries_list);
+      return true;
+    }
+  else
+    {
+      std::cout << "CollectionProcess::writeBase error: cannot open "
+                << tmp_path << std::endl;
+      return false;
+    }
+}
+
+void
+CollectionProcess::planBase(ImportPlan &plan)
+{
+  plan = ImportPlan();
+  plan.matched_inp = books_entries_list.size();
+  plan.unmatched_inp = unmatched_inp;
+  plan.bytes_to_hash = total_size;
+
+  size_t hash_len = 0;
+  probeSpeed(plan, hash_len);
+  if(hash_len == 0)
+    {
+      // Probe has failed, length of hash sum is taken from hasher itself.
+      hash_len = hsh->buf_hashing(std::string()).size();
+    }
+
+  std::string vl = books_path.u8string();
+  plan.base_size = static_cast<double>(sizeof(uint16_t) + vl.size());
+
+  auto start = std::chrono::steady_clock::now();
+#ifndef USE_OPENMP
+  std::atomic<size_t> next_entry;
+  next_entry.store(0);
+  std::atomic<size_t> books;
+  books.store(0);
+  std::atomic<size_t> absent_books;
+  absent_books.store(0);
+  std::atomic<uint64_t> base_size;
+  base_size.store(0);
+  std::vector<std::thread> workers;
+  workers.reserve(thr_num);
+  for(int i = 0; i < thr_num; i++)
+    {
+      workers.emplace_back(std::thread([this, &next_entry, &books,
+                                        &absent_books, &base_size,
+                                        hash_len] {
+        for(;;)
+          {
+            if(cancel.load())
+              {
+                break;
+              }
+            size_t n = next_entry.fetch_add(1);
+            if(n >= books_entries_list.size())
+              {
+                break;
+              }
+            const InpEntry &ie = books_entries_list[n];
+            FileParseEntry fpe;
+            fpe.file_rel_path
+                = ie.arch_path.lexically_relative(books_path).u8string();
+            fpe.file_hash.resize(hash_len);
+            std::vector<BookMeta> meta;
+            parseInp(ie, fpe, meta);
+            absent_books.fetch_add(checkBooks(ie.arch_path, fpe, meta));
+            books.fetch_add(fpe.books.size());
+            base_size.fetch_add(sizeof(uint64_t) + baseEntry(fpe).size());
+            if(signal_progress)
+              {
+                signal_progress(
+                    static_cast<double>(n + 1),
+                    static_cast<double>(books_entries_list.size()));
+              }
+          }
+      }));
+    }
+  for(auto it = workers.begin(); it != workers.end(); it++)
+    {
+      it->join();
+    }
+  plan.books = books.load();
+  plan.absent_books = absent_books.load();
+  plan.base_size += static_cast<double>(base_size.load());
+#endif
+#ifdef USE_OPENMP
+  omp_set_num_threads(thr_num);
+  omp_set_dynamic(true);
+  int lvls = omp_get_max_active_levels();
+  omp_set_max_active_levels(omp_get_supported_active_levels());
+  size_t books = 0;
+  size_t absent_books = 0;
+  uint64_t base_size = 0;
+  size_t done = 0;
+#pragma omp parallel for schedule(dynamic)
+  for(auto it = books_entries_list.begin(); it != books_entries_list.end();
+      it++)
+    {
+      bool cncl;
+#pragma omp atomic read
+      cncl = cancel;
+      if(cncl)
+        {
+          continue;
+        }
+      FileParseEntry fpe;
+      fpe.file_rel_path
+          = it->arch_path.lexically_relative(books_path).u8string();
+      fpe.file_hash.resize(hash_len);
+      std::vector<BookMeta> meta;
+      parseInp(*it, fpe, meta);
+      size_t absent = checkBooks(it->arch_path, fpe, meta);
+      size_t b_count = fpe.books.size();
+      uint64_t e_size = sizeof(uint64_t) + baseEntry(fpe).size();
+#pragma omp atomic update
+      absent_books += absent;
+#pragma omp atomic update
+      books += b_count;
+#pragma omp atomic update
+      base_size += e_size;
+      size_t n;
+#pragma omp atomic capture
+      n = ++done;
+      if(signal_progress)
+        {
+          signal_progress(static_cast<double>(n),
+                          static_cast<double>(books_entries_list.size()));
+        }
+    }
+  omp_set_dynamic(false);
+  omp_set_max_active_levels(lvls);
+  plan.books = books;
+  plan.absent_books = absent_books;
+  plan.base_size += static_cast<double>(base_size);
+#endif
+  plan.parse_time = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+  if(!interrupted())
+    {
+      saveInpxCaches();
+    }
+
+  // Each worker hashes one archive at a time, so hashing scales with the
+  // number of threads up to the number of cores, while disk throughput
+  // limits all workers together. Parsing runs concurrently with hashing.
+  double hash_thr = static_cast<double>(thr_num);
+#ifndef USE_OPENMP
+  double cores = static_cast<double>(std::thread::hardware_concurrency());
+#endif
+#ifdef USE_OPENMP
+  double cores = static_cast<double>(omp_get_num_procs());
+#endif
+  if(cores > 0.0 && hash_thr > cores)
+    {
+      hash_thr = cores;
+    }
+  double io_time = 0.0;
+  if(plan.read_speed > 0.0)
+    {
+      io_time = plan.bytes_to_hash / plan.read_speed;
+    }
+  double hash_time = 0.0;
+  if(plan.hash_speed > 0.0)
+    {
+      hash_time = plan.bytes_to_hash / (plan.hash_speed * hash_thr);
+    }
+  plan.estimated_time = std::max({ io_time, hash_time, plan.parse_time });
+}
+
+void
+CollectionProcess::probeSpeed(ImportPlan &plan, size_t &hash_len)
+{
+  // Up to probe_limit bytes of one of the first archives are read to measure
+  // disk throughput. Then read data are written to temporary file, which is
+  // hashed from page cache to measure hashing speed.
+  std::filesystem::path probe;
+  uintmax_t probe_sz = 0;
+  size_t count = 0;
+  for(auto it = books_entries_list.begin();
+      it != books_entries_list.end() && count < 16; it++, count++)
+    {
+      uintmax_t sz = static_cast<uintmax_t>(it->arch_size);
+      if(sz > probe_sz)
+        {
+          probe = it->arch_path;
+          probe_sz = sz;
+          if(probe_sz >= probe_limit)
+            {
+              break;
+            }
+        }
+    }
+  if(probe.empty())
+    {
+      return void();
+    }
+  if(probe_sz > probe_limit)
+    {
+      probe_sz = probe_limit;
+    }
+
+#ifdef __linux
+  // Archive can be in page cache already (after previous plan for
+  // example), then memory speed would be measured instead of disk one.
+  int fd = open(probe.c_str(), O_RDONLY);
+  if(fd >= 0)
+    {
+      posix_fadvise(fd, 0, static_cast<off_t>(probe_sz),
+                    POSIX_FADV_DONTNEED);
+      close(fd);
+    }
+#endif
+
+  std::string buf;
+  buf.resize(probe_sz);
+  std::fstream f;
+  f.open(probe, std::ios_base::in | std::ios_base::binary);
+  if(!f.is_open())
+    {
+      return void();
+    }
+  auto start = std::chrono::steady_clock::now();
+  f.read(buf.data(), buf.size());
+  buf.resize(static_cast<size_t>(f.gcount()));
+  double tm = std::chrono::duration<double>(std::chrono::steady_clock::now()
+                                            - start)
+                  .count();
+  f.close();
+  if(tm > 0.0)
+    {
+      plan.read_speed = static_cast<double>(buf.size()) / tm;
+    }
+
+  std::filesystem::path p
+      = af->temp_path() / std::filesystem::u8path(af->randomFileName());
+  SelfRemovingPath srp(p);
+  f.open(srp.path, std::ios_base::out | std::ios_base::binary);
+  if(!f.is_open())
+    {
+      return void();
+    }
+  f.write(buf.c_str(), buf.size());
+  f.close();
+
+  start = std::chrono::steady_clock::now();
+  hash_len = hsh->file_hashing(srp.path).size();
+  tm = std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+           .count();
+  if(tm > 0.0)
+    {
+      plan.hash_speed = static_cast<double>(buf.size()) / tm;
+    }
+}
+
+std::string
+CollectionProcess::baseEntry(const FileParseEntry &fpe)
+{
+  uint16_t val16;
+  ByteOrder bo;
+  size_t sz_16 = sizeof(val16);
+  size_t sz;
+  uint64_t val64;
+  size_t sz_64 = sizeof(val64);
+
+  std::string entry;
+
+  val16 = static_cast<uint16_t>(fpe.file_rel_path.size());
+  bo = val16;
+  bo.get_little(val16);
+
+  entry.resize(sz_16);
+  std::memcpy(&entry[0], &val16, sz_16);
+
+  entry += fpe.file_rel_path;
+
+  val16 = static_cast<uint16_t>(fpe.file_hash.size());
+  bo = val16;
+  bo.get_little(val16);
+  sz = entry.size();
+  entry.resize(sz + sz_16);
+  std::memcpy(&entry[sz], &val16, sz_16);
+
+  entry += fpe.file_hash;
+
+  for(auto it_b = fpe.books.begin(); it_b != fpe.books.end(); it_b++)
+    {
+      std::string book_entry;
+      for(int i = 1; i <= 6; i++)
+        {
+          switch(i)
+            {
+            case 1:
+              {
+                val16 = static_cast<uint16_t>(it_b->book_path.size());
+                break;
+              }
+            case 2:
+              {
+                val16 = static_cast<uint16_t>(it_b->book_author.size());
+                break;
+              }
+            case 3:
+              {
+                val16 = static_cast<uint16_t>(it_b->book_name.size());
+                break;
+              }
+            case 4:
+              {
+                val16 = static_cast<uint16_t>(it_b->book_series.size());
+                break;
+              }
+            case 5:
+              {
+                val16 = static_cast<uint16_t>(it_b->book_genre.size());
+                break;
+              }
+            case 6:
+              {
+                val16 = static_cast<uint16_t>(it_b->book_date.size());
+                break;
+              }
+            default:
+              {
+                break;
+              }
+            }
+          bo = val16;
+          bo.get_little(val16);
+          sz = book_entry.size();
+          book_entry.resize(sz + sz_16);
+          std::memcpy(&book_entry[sz], &val16, sz_16);
+
+          switch(i)
+            {
+            case 1:
+              {
+                book_entry += it_b->book_path;
+                break;
+              }
+            case 2:
+              {
+                book_entry += it_b->book_author;
+                break;
+              }
+            case 3:
+              {
+                book_entry += it_b->book_name;
+                break;
+              }
+            case 4:
+              {
+                sz = book_entry.size();
+                book_entry += it_b->book_series;
+                std::replace(book_entry.begin() + sz, book_entry.end(),
+                             series_number_separator, ' ');
+                break;
+              }
+            case 5:
+              {
+                book_entry += it_b->book_genre;
+                break;
+              }
+            case 6:
+              {
+                book_entry += it_b->book_date;
+                break;
+              }
+            default:
+              break;
+            }
+        }
+
+      val64 = static_cast<uint64_t>(book_entry.size());
+      bo = val64;
+      bo.get_little(val64);
+      sz = entry.size();
+      entry.resize(sz + sz_64);
+      std::memcpy(&entry[sz], &val64, sz_64);
+
+      entry += book_entry;
+    }
+  return entry;
+}
+
+bool
+CollectionProcess::readBase(
+    const std::filesystem::path &base_path,
+    std::filesystem::path &base_books_path,
+    std::vector<FileParseEntry> &result,
+    const std::unordered_map<uint64_t, size_t> *series_names)
+{
+  std::fstream f;
+  f.open(base_path, std::ios_base::in | std::ios_base::binary);
+  if(!f.is_open())
+    {
+      return false;
+    }
+  std::string bs;
+  f.seekg(0, std::ios_base::end);
+  bs.resize(f.tellg());
+  f.seekg(0, std::ios_base::beg);
+  f.read(bs.data(), bs.size());
+  f.close();
+
+  ByteOrder bo;
+  uint16_t val16;
+  size_t sz_16 = sizeof(val16);
+  uint64_t val64;
+  size_t sz_64 = sizeof(val64);
+
+  auto get_str = [&bs, &bo, &val16, sz_16](size_t &pos, const size_t &end,
+                                           std::string &str) {
+    if(pos + sz_16 > end)
+      {
+        return false;
+      }
+    std::memcpy(&val16, &bs[pos], sz_16);
+    pos += sz_16;
+    bo.set_little(val16);
+    val16 = bo;
+    if(pos + val16 > end)
+      {
+        return false;
+      }
+    str = bs.substr(pos, val16);
+    pos += val16;
+    return true;
+  };
+
+  size_t pos = 0;
+  std::string str;
+  if(!get_str(pos, bs.size(), str))
+    {
+      return false;
+    }
+  base_books_path = std::filesystem::u8path(str);
+  while(pos < bs.size())
+    {
+      if(pos + sz_64 > bs.size())
+        {
+          break;
+        }
+      std::memcpy(&val64, &bs[pos], sz_64);
+      pos += sz_64;
+      bo.set_little(val64);
+      val64 = bo;
+      if(pos + val64 > bs.size())
+        {
+          break;
+        }
+      size_t end = pos + val64;
+      FileParseEntry fpe;
+      if(!get_str(pos, end, fpe.file_rel_path)
+         || !get_str(pos, end, fpe.file_hash))
+        {
+          break;
+        }
+      while(pos + sz_64 <= end)
+        {
+          uint64_t b_offset = static_cast<uint64_t>(pos);
+          std::memcpy(&val64, &bs[pos], sz_64);
+          pos += sz_64;
+          bo.set_little(val64);
+          val64 = bo;
+          size_t b_end = pos + val64;
+          if(b_end > end)
+            {
+              break;
+            }
+          BookParseEntry bpe;
+          if(!get_str(pos, b_end, bpe.book_path)
+             || !get_str(pos, b_end, bpe.book_author)
+             || !get_str(pos, b_end, bpe.book_name)
+             || !get_str(pos, b_end, bpe.book_series)
+             || !get_str(pos, b_end, bpe.book_genre)
+             || !get_str(pos, b_end, bpe.book_date))
+            {
+              break;
+            }
+          if(series_names)
+            {
+              // Series number is separated from series name again by
+              // series index written together with base.
+              auto it_s = series_names->find(b_offset);
+              if(it_s != series_names->end()
+                 && it_s->second < bpe.book_series.size()
+                 && bpe.book_series[it_s->second] == ' ')
+                {
+                  bpe.book_series[it_s->second] = series_number_separator;
+                }
+            }
+          pos = b_end;
+          fpe.books.emplace_back(std::move(bpe));
+        }
+      if(pos != end)
+        {
+          std::cout << "CollectionProcess::readBase error: incorrect entry "
+                    << fpe.file_rel_path << std::endl;
+          result.clear();
+          return false;
+        }
+      result.emplace_back(std::move(fpe));
+    }
+  if(pos != bs.size())
+    {
+      std::cout << "CollectionProcess::readBase error: incorrect file "
+                << base_path << std::endl;
+      result.clear();
+      return false;
+    }
+
+  return true;
+}
+
+void
+CollectionProcess::readSeriesNames(
+    const std::filesystem::path &index_path,
+    std::unordered_map<uint64_t, size_t> &names)
+{
+  // Series index keys do not include series number, so size of series name
+  // of every book record of existing base is known.
+  IndexReader reader;
+  if(!reader.open(index_path))
+    {
+      return void();
+    }
+  std::vector<std::string> keys = reader.keys();
+  std::vector<uint64_t> offsets;
+  for(auto it = keys.begin(); it != keys.end(); it++)
+    {
+      offsets.clear();
+      reader.find(*it, offsets);
+      for(auto it_o = offsets.begin(); it_o != offsets.end(); it_o++)
+        {
+          names[*it_o] = it->size();
+        }
+    }
+}
+
+int
+CollectionProcess::takeThreads(const int &chunks)
+{
+  // Threads in addition to calling one are taken from scheduler budget, so
+  // jobs of import queue together do not use more threads than budget.
+  int result = chunks - 1;
+  if(scheduler && result > 0)
+    {
+      result = scheduler->tryAcquireThreads(result);
+    }
+  return result;
+}
+
+void
+CollectionProcess::startTrace()
+{
+  if(options.write_trace)
+    {
+      delete trace;
+      trace = new TraceRecorder;
+    }
+}
+
+void
+CollectionProcess::finishTrace(const std::filesystem::path &coll_path)
+{
+  if(trace)
+    {
+      trace->write(coll_path / std::filesystem::u8path("trace.json"));
+      delete trace;
+      trace = nullptr;
+    }
+}
+
+void
+CollectionProcess::saveInpxCaches()
+{
+  for(auto it = inpx_caches.begin(); it != inpx_caches.end(); it++)
+    {
+      it->second->save();
+    }
+}
+
+std::filesystem::path
+CollectionProcess::collectionPath()
+{
+  std::filesystem::path result = af->homePath();
+  result /= std::filesystem::u8path(".local/share/MyLibrary/Collections");
+  result /= std::filesystem::u8path(coll_name);
+  return result;
+}
+
+void
+CollectionProcess::removeDuplicates()
+{
+  TraceScope ts(trace, "remove duplicates");
+  // Archives are identified by hash sums, so the same archive found in
+  // several sources is written to base only once. Its book records are
+  // united, records with equal book_path are written once too.
+  std::unordered_map<std::string, size_t> hashes;
+  std::vector<std::unordered_set<std::string>> book_paths;
+  hashes.reserve(base.size());
+  book_paths.resize(base.size());
+  size_t dup_arch = 0;
+  size_t dup_books = 0;
+  for(size_t i = 0; i < base.size(); i++)
+    {
+      FileParseEntry &fpe = base[i];
+      size_t kept = i;
+      if(!fpe.file_hash.empty())
+        {
+          auto res = hashes.emplace(fpe.file_hash, i);
+          if(!res.second)
+            {
+              kept = res.first->second;
+              dup_arch++;
+            }
+        }
+      FileParseEntry &kept_fpe = base[kept];
+      std::unordered_set<std::string> &kept_paths = book_paths[kept];
+      auto it_end = fpe.books.end();
+      if(kept != i)
+        {
+          kept_fpe.books.reserve(kept_fpe.books.size() + fpe.books.size());
+        }
+      for(auto it = fpe.books.begin(); it != it_end; it++)
+        {
+          if(!kept_paths.insert(it->book_path).second)
+            {
+              dup_books++;
+            }
+          else if(kept != i)
+            {
+              kept_fpe.books.emplace_back(std::move(*it));
+            }
+          else
+            {
+              continue;
+            }
+          // Marks record as removed.
+          it->book_path.clear();
+        }
+      if(kept == i)
+        {
+          fpe.books.erase(std::remove_if(fpe.books.begin(), fpe.books.end(),
+                                         [](BookParseEntry &el) {
+                                           return el.book_path.empty();
+                                         }),
+                          fpe.books.end());
+        }
+      else
+        {
+          fpe.books.clear();
+          fpe.file_rel_path.clear();
+        }
+    }
+  base.erase(std::remove_if(base.begin(), base.end(),
+                            [](FileParseEntry &el) {
+                              return el.file_rel_path.empty();
+                            }),
+             base.end());
+  if(dup_arch > 0 || dup_books > 0)
+    {
+      std::cout << "CollectionProcess::removeDuplicates: " << dup_arch
+                << " duplicate archives, " << dup_books
+                << " duplicate records removed" << std::endl;
+    }
+}
+
+void
+CollectionProcess::stopAll()
+{
+#ifndef USE_OPENMP
+  cancel.store(true);
+#endif
+#ifdef USE_OPENMP
+#pragma omp atomic write
+  cancel = true;
+#endif
+  if(hsh)
+    {
+      hsh->cancelAll();
+    }
+  if(scheduler)
+    {
+      scheduler->wakeAll();
+    }
+}
+
+void
+CollectionProcess::setOptions(const ImportOptions &options)
+{
+  this->options = options;
+}
+
+bool
+CollectionProcess::interrupted()
+{
+#ifndef USE_OPENMP
+  return cancel.load();
+#endif
+#ifdef USE_OPENMP
+  bool cncl;
+#pragma omp atomic read
+  cncl = cancel;
+  return cncl;
+#endif
+}
+
+void
+CollectionProcess::setScheduler(
+    const std::shared_ptr<ImportScheduler> &scheduler)
+{
+  this->scheduler = scheduler;
+}
+
+std::string
+CollectionProcess::hashArchive(const std::filesystem::path &arch_path)
+{
+  std::string result;
+  {
+    TraceScope ts(trace, "wait io");
+    if(scheduler && !scheduler->acquireIo([this] {
+         return interrupted();
+       }))
+      {
+        return result;
+      }
+  }
+  TraceScope ts(trace, "hash", arch_path.filename().u8string());
+  // ReadEngine passes whole archive to hasher (Hasher can not hash data by
+  // parts), so archives are read by it while they fit into read_memory
+  // together with archives of other threads.
+  bool read = false;
+  if(read_pool)
+    {
+      std::error_code ec;
+      uintmax_t sz = std::filesystem::file_size(arch_path, ec);
+      ReadEngineSlot *slot = nullptr;
+      if(!ec)
+        {
+          slot = read_pool->acquire(static_cast<uint64_t>(sz));
+        }
+      if(slot)
+        {
+          read = slot->engine->readFile(arch_path, slot->buf, [this] {
+            return interrupted();
+          });
+          if(read)
+            {
+              result = hsh->buf_hashing(slot->buf);
+            }
+          read_pool->release(slot);
+        }
+    }
+  if(!read && !interrupted())
+    {
+      result = hsh->file_hashing(arch_path);
+    }
+  if(scheduler)
+    {
+      scheduler->releaseIo();
+    }
+  return result;
+}
+
+void
+CollectionProcess::createReadPool()
+{
+  delete read_pool;
+  read_pool = nullptr;
+  if(options.reader != ImportOptions::Standard)
+    {
+      read_pool = new ReadEnginePool(
+          options.reader == ImportOptions::IoUring ? ReadEngine::IoUring
+                                                   : ReadEngine::Pread,
+          static_cast<unsigned>(options.queue_depth), read_memory);
+    }
+}
+
+void
+CollectionProcess::parseInp(const InpEntry &ie, FileParseEntry &fpe,
+                            std::vector<BookMeta> &meta,
+                            const std::function<void()> &io_done)
+{
+  TraceScope ts(trace, "parse", ie.entry.filename);
+  if(ie.orphan)
+    {
+      parseArchive(ie, fpe, meta);
+      return void();
+    }
+
+  std::shared_ptr<InpxCache> cache;
+  auto it_c = inpx_caches.find(ie.inpx_path.u8string());
+  if(it_c != inpx_caches.end())
+    {
+      cache = it_c->second;
+      if(fpe.books.empty() && cache->find(ie.entry.filename, fpe.books, meta))
+        {
+          if(io_done)
+            {
+              io_done();
+            }
+          return void();
+        }
+    }
+
+  // .inp files stored without compression are parsed directly from mapped
+  // .inpx file, deflated ones are unpacked from it to buffer of thread,
+  // which is reused for next .inp files. Other ones are unpacked by
+  // LibArchive.
+  thread_local std::string inp_buf;
+  std::string &fl_buf = inp_buf;
+  std::string_view fl_str;
+  bool mapped = false;
+  bool unpacked = false;
+  auto it_m = inpx_maps.find(ie.inpx_path.u8string());
+  if(it_m != inpx_maps.end())
+    {
+      if(ie.inp_stored)
+        {
+          mapped = ZipIndex::storedData(it_m->second->data(), ie.inp_offset,
+                                        ie.inp_size, fl_str);
+        }
+      else if(ie.inp_deflated)
+        {
+          unpacked = ZipIndex::inflatedData(it_m->second->data(),
+                                            ie.inp_offset, ie.inp_comp_size,
+                                            ie.inp_size, fl_buf);
+          fl_str = fl_buf;
+        }
+    }
+  if(!mapped && !unpacked)
+    {
+      LibArchive la(af);
+      fl_buf = la.unpackByPositionStr(ie.inpx_path, ie.entry);
+      fl_str = fl_buf;
+    }
+
+  // Some old collections have .inp files in CP1251 or KOI8-R.
+  InpEncoding enc;
+  if(!enc.validUtf8(fl_str))
+    {
+      if(mapped)
+        {
+          fl_buf.assign(fl_str);
+        }
+      enc.toUtf8(fl_buf);
+      fl_str = fl_buf;
+    }
+  // Validation has read whole mapped .inp file too.
+  if(io_done)
+    {
+      io_done();
+    }
+
+  if(!fl_str.empty())
+    {
+      int chunks;
+#ifndef USE_OPENMP
+      chunks = thr_num / (active_inp.fetch_add(1) + 1);
+#endif
+#ifdef USE_OPENMP
+#pragma omp atomic capture
+      chunks = ++active_inp;
+      chunks = thr_num / chunks;
+#endif
+      size_t max_chunks = fl_str.size() / min_chunk_size;
+      if(static_cast<size_t>(chunks) > max_chunks)
+        {
+          chunks = static_cast<int>(max_chunks);
+        }
+      if(chunks < 1)
+        {
+          chunks = 1;
+        }
+      int extra_thr = takeThreads(chunks);
+      chunks = extra_thr + 1;
+
+      std::string find_str = { 0x0d, 0x0a };
+      std::vector<std::string::size_type> bounds;
+      bounds.reserve(chunks + 1);
+      bounds.push_back(0);
+      for(int i = 1; i < chunks; i++)
+        {
+          std::string::size_type n
+              = fl_str.size() / static_cast<size_t>(chunks) * i;
+          if(n < bounds.back())
+            {
+              continue;
+            }
+          n = fl_str.find(find_str, n);
+          if(n == std::string::npos)
+            {
+              break;
+            }
+          bounds.push_back(n + find_str.size());
+        }
+      bounds.push_back(fl_str.size());
+
+      auto canceled = [this] {
+        return interrupted();
+      };
+      if(bounds.size() == 2)
+        {
+          InpParser parser;
+          parser.parseChunk(fl_str, bounds[0], bounds[1], fpe.books, meta,
+                            canceled);
+        }
+      else
+        {
+          std::vector<std::vector<BookParseEntry>> parsed;
+          parsed.resize(bounds.size() - 1);
+          std::vector<std::vector<BookMeta>> parsed_meta;
+          parsed_meta.resize(parsed.size());
+#ifndef USE_OPENMP
+          std::vector<std::thread> thrs;
+          thrs.reserve(parsed.size() - 1);
+          for(size_t i = 1; i < parsed.size(); i++)
+            {
+              thrs.emplace_back(std::thread([this, &fl_str, &bounds, &parsed,
+                                             &parsed_meta, &canceled, i] {
+                ThreadPriority tp(options);
+                InpParser parser;
+                parser.parseChunk(fl_str, bounds[i], bounds[i + 1],
+                                  parsed[i], parsed_meta[i], canceled);
+              }));
+            }
+          InpParser parser;
+          parser.parseChunk(fl_str, bounds[0], bounds[1], parsed[0],
+                            parsed_meta[0], canceled);
+          for(auto it = thrs.begin(); it != thrs.end(); it++)
+            {
+              it->join();
+            }
+#endif
+#ifdef USE_OPENMP
+          int n_chunks = static_cast<int>(parsed.size());
+#pragma omp parallel for num_threads(n_chunks)
+          for(int i = 0; i < n_chunks; i++)
+            {
+              ThreadPriority tp(options);
+              InpParser parser;
+              parser.parseChunk(fl_str, bounds[i], bounds[i + 1], parsed[i],
+                                parsed_meta[i], canceled);
+            }
+#endif
+          size_t sz = fpe.books.size();
+          for(auto it = parsed.begin(); it != parsed.end(); it++)
+            {
+              sz += it->size();
+            }
+          fpe.books.reserve(sz);
+          meta.reserve(sz);
+          for(size_t i = 0; i < parsed.size(); i++)
+            {
+              fpe.books.insert(fpe.books.end(),
+                               std::make_move_iterator(parsed[i].begin()),
+                               std::make_move_iterator(parsed[i].end()));
+              meta.insert(meta.end(), parsed_meta[i].begin(),
+                          parsed_meta[i].end());
+            }
+        }
+      if(scheduler)
+        {
+          scheduler->releaseThreads(extra_thr);
+        }
+#ifndef USE_OPENMP
+      active_inp.fetch_sub(1);
+#endif
+#ifdef USE_OPENMP
+#pragma omp atomic update
+      active_inp--;
+#endif
+    }
+
+  // Buffer of unusually large .inp file is not kept.
+  if(fl_buf.capacity() > max_inp_buffer)
+    {
+      std::string().swap(fl_buf);
+    }
+
+  // Parsing could be stopped in the middle of .inp file, so its records
+  // are not cached.
+  if(cache && !interrupted())
+    {
+      cache->add(ie.entry.filename, fpe.books, meta);
+    }
+}
+
+void
+CollectionProcess::parseArchive(const InpEntry &ie, FileParseEntry &fpe,
+                                std::vector<BookMeta> &meta)
+{
+  std::vector<ArchEntry> members;
+  {
+    LibArchive la(af);
+    la.fileNames(ie.arch_path, members);
+  }
+  std::string ext = ".fb2";
+  members.erase(
+      std::remove_if(members.begin(), members.end(),
+                     [&ext](const ArchEntry &el) {
+                       return el.filename.size() < ext.size()
+                              || !std::equal(
+                                  ext.begin(), ext.end(),
+                                  el.filename.end() - ext.size(),
+                                  [](const char &el1, const char &el2) {
+                                    return el1
+                                           == std::tolower(
+                                               static_cast<unsigned char>(
+                                                   el2));
+                                  });
+                     }),
+      members.end());
+
+  // Books of zip archives are unpacked from mapped archive, so only headers
+  // of books are unpacked, if book cache is not made.
+  ZipIndex zi;
+  MappedFile zip_map;
+  std::string_view zip;
+  if(zi.readCentralDirectory(ie.arch_path) && zip_map.open(ie.arch_path))
+    {
+      zip = zip_map.data();
+    }
+
+  // Books are parsed in chunks in parallel like .inp files.
+  int chunks;
+#ifndef USE_OPENMP
+  chunks = thr_num / (active_inp.fetch_add(1) + 1);
+#endif
+#ifdef USE_OPENMP
+#pragma omp atomic capture
+  chunks = ++active_inp;
+  chunks = thr_num / chunks;
+#endif
+  if(static_cast<size_t>(chunks) > members.size())
+    {
+      chunks = static_cast<int>(members.size());
+    }
+  if(chunks < 1)
+    {
+      chunks = 1;
+    }
+  int extra_thr = takeThreads(chunks);
+  chunks = extra_thr + 1;
+
+  std::vector<std::vector<BookParseEntry>> parsed;
+  parsed.resize(chunks);
+  std::vector<std::vector<BookMeta>> parsed_meta;
+  parsed_meta.resize(chunks);
+  std::vector<std::vector<BookCachePending>> cached;
+  cached.resize(chunks);
+  size_t chunk_sz = members.size() / static_cast<size_t>(chunks);
+  auto parse_members = [this, &ie, &fpe, &members, &zi, &zip, &parsed,
+                        &parsed_meta, &cached, chunks,
+                        chunk_sz](const size_t &i) {
+    size_t beg = i * chunk_sz;
+    size_t end = static_cast<int>(i) == chunks - 1 ? members.size()
+                                                   : beg + chunk_sz;
+    LibArchive la(af);
+    Fb2Parser parser;
+    for(size_t j = beg; j < end; j++)
+      {
+        if(interrupted())
+          {
+            break;
+          }
+        std::string book;
+        if(!unpackZipBook(zip, zi, members[j].filename, book))
+          {
+            book = la.unpackByPositionStr(ie.arch_path, members[j]);
+          }
+        BookParseEntry bpe;
+        if(parser.description(book, bpe))
+          {
+            bpe.book_path = members[j].filename;
+            BookMeta bm;
+            bm.size = members[j].size;
+            parsed[i].emplace_back(std::move(bpe));
+            parsed_meta[i].push_back(bm);
+            // Book is unpacked once for base and for cache.
+            BookCachePending pb;
+            if(book_cache && book_cache->bookData(book, pb))
+              {
+                pb.bce.arch_path = fpe.file_rel_path;
+                pb.bce.book_path = members[j].filename;
+                cached[i].emplace_back(std::move(pb));
+              }
+          }
+      }
+  };
+#ifndef USE_OPENMP
+  std::vector<std::thread> thrs;
+  thrs.reserve(parsed.size() - 1);
+  for(size_t i = 1; i < parsed.size(); i++)
+    {
+      thrs.emplace_back(std::thread([this, &parse_members, i] {
+        ThreadPriority tp(options);
+        parse_members(i);
+      }));
+    }
+  parse_members(0);
+  for(auto it = thrs.begin(); it != thrs.end(); it++)
+    {
+      it->join();
+    }
+#endif
+#ifdef USE_OPENMP
+#pragma omp parallel for num_threads(chunks)
+  for(int i = 0; i < chunks; i++)
+    {
+      ThreadPriority tp(options);
+      parse_members(static_cast<size_t>(i));
+    }
+#endif
+  for(size_t i = 0; i < parsed.size(); i++)
+    {
+      fpe.books.insert(fpe.books.end(),
+                       std::make_move_iterator(parsed[i].begin()),
+                       std::make_move_iterator(parsed[i].end()));
+      meta.insert(meta.end(), parsed_meta[i].begin(), parsed_meta[i].end());
+    }
+  if(book_cache)
+    {
+      std::vector<BookCachePending> books;
+      for(size_t i = 0; i < cached.size(); i++)
+        {
+          books.insert(books.end(), std::make_move_iterator(cached[i].begin()),
+                       std::make_move_iterator(cached[i].end()));
+        }
+      book_cache->commit(ie.base_order, std::move(books));
+    }
+  if(scheduler)
+    {
+      scheduler->releaseThreads(extra_thr);
+    }
+
+#ifndef USE_OPENMP
+  active_inp.fetch_sub(1);
+#endif
+#ifdef USE_OPENMP
+#pragma omp atomic update
+  active_inp--;
+#endif
+}
+
+bool
+CollectionProcess::unpackZipBook(const std::string_view &zip,
+                                 const ZipIndex &zi, const std::string &name,
+                                 std::string &book)
+{
+  if(zip.empty())
+    {
+      return false;
+    }
+  // Book cache needs whole book (covers are placed after text), parser of
+  // base needs encoding declaration and description only.
+  std::string marker = "</description>";
+  uint64_t offset;
+  uint64_t comp_sz;
+  uint64_t sz;
+  std::string_view data;
+  if(zi.storedEntry(name, offset, sz)
+     && ZipIndex::storedData(zip, offset, sz, data))
+    {
+      std::string::size_type n
+          = book_cache ? std::string::npos : data.find(marker);
+      book = data.substr(0, n == std::string::npos ? n : n + marker.size());
+      return true;
+    }
+  if(zi.deflatedEntry(name, offset, comp_sz, sz))
+    {
+      if(book_cache)
+        {
+          return ZipIndex::inflatedData(zip, offset, comp_sz, sz, book);
+        }
+      return ZipIndex::inflatedPrefix(zip, offset, comp_sz, sz, marker,
+                                      book);
+    }
+  return false;
+}
+
+size_t
+CollectionProcess::checkBooks(const std::filesystem::path &arch_path,
+                              FileParseEntry &fpe, std::vector<BookMeta> &meta)
+{
+  ZipIndex zi;
+  if(!zi.readCentralDirectory(arch_path))
+    {
+      return 0;
+    }
+  return checkBooks(zi, arch_path, fpe, meta);
+}
+
+size_t
+CollectionProcess::checkBooks(const ZipIndex &zi,
+                              const std::filesystem::path &arch_path,
+                              FileParseEntry &fpe, std::vector<BookMeta> &meta)
+{
+  TraceScope ts(trace, "check books");
+  // Books and meta are compacted together to keep their indexes equal.
+  size_t sz = fpe.books.size();
+  size_t kept = 0;
+  for(size_t i = 0; i < fpe.books.size(); i++)
+    {
+      // Records, which can not be checked, are kept.
+      if(zi.contains(fpe.books[i].book_path)
+         || zi.uncheckable(fpe.books[i].book_path))
+        {
+          if(kept != i)
+            {
+              fpe.books[kept] = std::move(fpe.books[i]);
+              meta[kept] = meta[i];
+            }
+          kept++;
+        }
+    }
+  fpe.books.resize(kept);
+  meta.resize(kept);
+  sz -= fpe.books.size();
+  if(sz > 0)
+    {
+      std::cout << "CollectionProcess::checkBooks: " << sz
+                << " records are absent in " << arch_path << std::endl;
+    }
+  return sz;
+}
+
@@ -16,7 +16,9 @@
 #include <CollectionProcessGui.h>
 #include <gtkmm-4.0/gtkmm/button.h>
 #include <gtkmm-4.0/gtkmm/grid.h>
+#include <iomanip>
 #include <libintl.h>
+#include <sstream>
 
 #ifdef USE_OPENMP
 #include <omp.h>
@@ -43,14 +45,48 @@ CollectionProcessGui::~CollectionProcessGui()
 }
 
 void
-CollectionProcessGui::createWindow(const std::filesystem::path &inpx_path,
-                                   const std::filesystem::path &books_path,
+CollectionProcessGui::createWindow(const std::vector<ImportSource> &sources,
                                    const std::string &coll_name)
+{
+  progressWindow(gettext("Collection creation"), gettext("Import progress"));
+
+  launchProc(sources, coll_name);
+}
+
+void
+CollectionProcessGui::createPlanWindow(
+    const std::vector<ImportSource> &sources)
+{
+  progressWindow(gettext("Import plan"), gettext("Planning progress"));
+
+  launchPlan(sources);
+}
+
+void
+CollectionProcessGui::createVerifyWindow(const std::string &coll_name,
+                                         const double &rate_limit)
+{
+  progressWindow(gettext("Collection verification"),
+                 gettext("Verification progress"));
+
+  coll_proc->setRateLimit(rate_limit);
+  launchVerify(coll_name);
+}
+
+void
+CollectionProcessGui::setOptions(const ImportOptions &options)
+{
+  coll_proc->setOptions(options);
+}
+
+void
+CollectionProcessGui::progressWindow(const Glib::ustring &title,
+                                     const Glib::ustring &operation)
 {
   main_window = new Gtk::Window;
   main_window->set_application(parent_window->get_application());
   main_window->set_transient_for(*parent_window);
-  main_window->set_title(gettext("Collection creation"));
+  main_window->set_title(title);
   main_window->set_name("MLwindow");
   main_window->set_modal(true);
   main_window->set_deletable(false);
@@ -65,7 +101,7 @@ CollectionProcessGui::createWindow(const std::filesystem::path &inpx_path,
   current_operation->set_margin(5);
   current_operation->set_halign(Gtk::Align::CENTER);
   current_operation->set_name("windowLabel");
-  current_operation->set_text(gettext("Import progress"));
+  current_operation->set_text(operation);
   grid->attach(*current_operation, 0, 0, 1, 1);
 
   progress = Gtk::make_managed<Gtk::ProgressBar>();
@@ -99,13 +135,10 @@ CollectionProcessGui::createWindow(const std::filesystem::path &inpx_path,
       false);
 
   main_window->present();
-
-  launchProc(inpx_path, books_path, coll_name);
 }
 
 void
-CollectionProcessGui::launchProc(const std::filesystem::path &inpx_path,
-                                 const std::filesystem::path &books_path,
+CollectionProcessGui::launchProc(const std::vector<ImportSource> &sources,
                                  const std::string &coll_name)
 {
   progress_disp = new Glib::Dispatcher;
@@ -124,8 +157,8 @@ CollectionProcessGui::launchProc(const std::filesystem::path &inpx_path,
   };
 
 #ifndef USE_OPENMP
-  std::thread work_thr([this, inpx_path, books_path, coll_name] {
-    coll_proc->collectFiles(inpx_path, books_path, coll_name);
+  std::thread work_thr([this, sources, coll_name] {
+    coll_proc->collectFiles(sources, coll_name);
     coll_proc->createBase();
     ops_completed_disp->emit();
   });
@@ -137,7 +170,7 @@ CollectionProcessGui::launchProc(const std::filesystem::path &inpx_path,
     omp_event_handle_t event;
 #pragma omp task detach(event)
     {
-      coll_proc->collectFiles(inpx_path, books_path, coll_name);
+      coll_proc->collectFiles(sources, coll_name);
       coll_proc->createBase();
       ops_completed_disp->emit();
       omp_fulfill_event(event);
@@ -188,3 +221,280 @@ CollectionProcessGui::completeMessage()
   close->signal_clicked().connect(std::bind(&Gtk::Window::close, main_window));
   grid->attach(*close, 0, 1, 1, 1);
 }
+
+void
+CollectionProcessGui::launchPlan(const std::vector<ImportSource> &sources)
+{
+  progress_disp = new Glib::Dispatcher;
+  progress_disp->connect([this] {
+    progress->set_fraction(parsed_bytes.load() / total_size.load());
+  });
+
+  ops_completed_disp = new Glib::Dispatcher;
+  ops_completed_disp->connect(
+      std::bind(&CollectionProcessGui::planMessage, this));
+
+  coll_proc->signal_progress = [this](const double &pb, const double &ts) {
+    parsed_bytes.store(pb);
+    total_size.store(ts);
+    progress_disp->emit();
+  };
+
+#ifndef USE_OPENMP
+  std::thread work_thr([this, sources] {
+    coll_proc->collectFiles(sources, std::string());
+    coll_proc->planBase(plan);
+    ops_completed_disp->emit();
+  });
+  work_thr.detach();
+#endif
+#ifdef USE_OPENMP
+#pragma omp masked
+  {
+    omp_event_handle_t event;
+#pragma omp task detach(event)
+    {
+      coll_proc->collectFiles(sources, std::string());
+      coll_proc->planBase(plan);
+      ops_completed_disp->emit();
+      omp_fulfill_event(event);
+    }
+  }
+#endif
+}
+
+void
+CollectionProcessGui::planMessage()
+{
+  if(canceled)
+    {
+      completeMessage();
+      return void();
+    }
+
+  std::vector<std::tuple<Glib::ustring, Glib::ustring>> rows;
+  rows.emplace_back(std::make_tuple(
+      Glib::ustring(gettext("Matched .inp files:")),
+      Glib::ustring::format(static_cast<unsigned long>(plan.matched_inp))));
+  rows.emplace_back(std::make_tuple(
+      Glib::ustring(gettext("Unmatched .inp files:")),
+      Glib::ustring::format(static_cast<unsigned long>(plan.unmatched_inp))));
+  rows.emplace_back(std::make_tuple(
+      Glib::ustring(gettext("Books:")),
+      Glib::ustring::format(static_cast<unsigned long>(plan.books))));
+  rows.emplace_back(std::make_tuple(
+      Glib::ustring(gettext("Books absent in archives:")),
+      Glib::ustring::format(static_cast<unsigned long>(plan.absent_books))));
+  rows.emplace_back(
+      std::make_tuple(Glib::ustring(gettext("Total size to hash:")),
+                      sizeString(plan.bytes_to_hash)));
+  rows.emplace_back(
+      std::make_tuple(Glib::ustring(gettext("Projected base file size:")),
+                      sizeString(plan.base_size)));
+  rows.emplace_back(
+      std::make_tuple(Glib::ustring(gettext("Disk read speed:")),
+                      sizeString(plan.read_speed) + gettext("/s")));
+  rows.emplace_back(
+      std::make_tuple(Glib::ustring(gettext("Hashing speed (one thread):")),
+                      sizeString(plan.hash_speed) + gettext("/s")));
+  rows.emplace_back(std::make_tuple(Glib::ustring(gettext("Parsing time:")),
+                                    timeString(plan.parse_time)));
+  rows.emplace_back(
+      std::make_tuple(Glib::ustring(gettext("Estimated import time:")),
+                      timeString(plan.estimated_time)));
+
+  tableMessage(rows, Glib::ustring());
+}
+
+void
+CollectionProcessGui::launchVerify(const std::string &coll_name)
+{
+  progress_disp = new Glib::Dispatcher;
+  progress_disp->connect([this] {
+    double pb = parsed_bytes.load();
+    double fr = pb / total_size.load();
+    progress->set_fraction(fr);
+    double tm = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - verify_start)
+                    .count();
+    std::stringstream strm;
+    strm.imbue(std::locale("C"));
+    strm << static_cast<int>(fr * 100.0) << "%";
+    Glib::ustring txt(strm.str());
+    if(tm > 0.0)
+      {
+        txt += " (" + sizeString(pb / tm) + gettext("/s") + ")";
+      }
+    progress->set_text(txt);
+  });
+
+  ops_completed_disp = new Glib::Dispatcher;
+  ops_completed_disp->connect(
+      std::bind(&CollectionProcessGui::verifyMessage, this));
+
+  coll_proc->signal_progress = [this](const double &pb, const double &ts) {
+    parsed_bytes.store(pb);
+    total_size.store(ts);
+    progress_disp->emit();
+  };
+
+  verify_start = std::chrono::steady_clock::now();
+#ifndef USE_OPENMP
+  std::thread work_thr([this, coll_name] {
+    coll_proc->verifyBase(coll_name, verify_report);
+    ops_completed_disp->emit();
+  });
+  work_thr.detach();
+#endif
+#ifdef USE_OPENMP
+#pragma omp masked
+  {
+    omp_event_handle_t event;
+#pragma omp task detach(event)
+    {
+      coll_proc->verifyBase(coll_name, verify_report);
+      ops_completed_disp->emit();
+      omp_fulfill_event(event);
+    }
+  }
+#endif
+}
+
+void
+CollectionProcessGui::verifyMessage()
+{
+  if(canceled)
+    {
+      completeMessage();
+      return void();
+    }
+
+  std::vector<std::tuple<Glib::ustring, Glib::ustring>> rows;
+  rows.emplace_back(std::make_tuple(
+      Glib::ustring(gettext("Checked archives:")),
+      Glib::ustring::format(
+          static_cast<unsigned long>(verify_report.checked))));
+  rows.emplace_back(std::make_tuple(
+      Glib::ustring(gettext("Mismatched archives:")),
+      Glib::ustring::format(
+          static_cast<unsigned long>(verify_report.mismatched.size()))));
+  rows.emplace_back(std::make_tuple(
+      Glib::ustring(gettext("Missing archives:")),
+      Glib::ustring::format(
+          static_cast<unsigned long>(verify_report.missing.size()))));
+  rows.emplace_back(std::make_tuple(
+      Glib::ustring(gettext("Extra files:")),
+      Glib::ustring::format(
+          static_cast<unsigned long>(verify_report.extra.size()))));
+  double speed = 0.0;
+  if(verify_report.elapsed_time > 0.0)
+    {
+      speed = verify_report.bytes_hashed / verify_report.elapsed_time;
+    }
+  rows.emplace_back(
+      std::make_tuple(Glib::ustring(gettext("Average speed:")),
+                      sizeString(speed) + gettext("/s")));
+  rows.emplace_back(
+      std::make_tuple(Glib::ustring(gettext("Verification time:")),
+                      timeString(verify_report.elapsed_time)));
+
+  Glib::ustring note;
+  if(verify_report.mismatched.size() > 0 || verify_report.missing.size() > 0
+     || verify_report.extra.size() > 0)
+    {
+      note = gettext("List of found problems has been saved to verify.txt "
+                     "file in collection directory.");
+    }
+  tableMessage(rows, note);
+}
+
+void
+CollectionProcessGui::tableMessage(
+    const std::vector<std::tuple<Glib::ustring, Glib::ustring>> &rows,
+    const Glib::ustring &note)
+{
+  main_window->unset_child();
+  main_window->set_default_size(1, 1);
+
+  Glib::RefPtr<Glib::MainContext> mc = Glib::MainContext::get_default();
+  while(mc->pending())
+    {
+      mc->iteration(true);
+    }
+
+  Gtk::Grid *grid = Gtk::make_managed<Gtk::Grid>();
+  grid->set_halign(Gtk::Align::FILL);
+  grid->set_valign(Gtk::Align::FILL);
+  main_window->set_child(*grid);
+
+  int row = 0;
+  for(auto it = rows.begin(); it != rows.end(); it++, row++)
+    {
+      Gtk::Label *lab = Gtk::make_managed<Gtk::Label>();
+      lab->set_margin(5);
+      lab->set_halign(Gtk::Align::START);
+      lab->set_name("windowLabel");
+      lab->set_text(std::get<0>(*it));
+      grid->attach(*lab, 0, row, 1, 1);
+
+      lab = Gtk::make_managed<Gtk::Label>();
+      lab->set_margin(5);
+      lab->set_halign(Gtk::Align::END);
+      lab->set_name("windowLabel");
+      lab->set_text(std::get<1>(*it));
+      grid->attach(*lab, 1, row, 1, 1);
+    }
+
+  if(!note.empty())
+    {
+      Gtk::Label *lab = Gtk::make_managed<Gtk::Label>();
+      lab->set_margin(5);
+      lab->set_halign(Gtk::Align::CENTER);
+      lab->set_name("windowLabel");
+      lab->set_max_width_chars(50);
+      lab->set_wrap_mode(Pango::WrapMode::WORD);
+      lab->set_justify(Gtk::Justification::CENTER);
+      lab->set_text(note);
+      grid->attach(*lab, 0, row, 2, 1);
+      row++;
+    }
+
+  Gtk::Button *close = Gtk::make_managed<Gtk::Button>();
+  close->set_margin(5);
+  close->set_halign(Gtk::Align::CENTER);
+  close->set_name("operationBut");
+  close->set_label(gettext("Close"));
+  close->signal_clicked().connect(std::bind(&Gtk::Window::close, main_window));
+  grid->attach(*close, 0, row, 2, 1);
+}
+
+Glib::ustring
+CollectionProcessGui::sizeString(const double &sz)
+{
+  std::vector<Glib::ustring> units
+      = { gettext("B"), gettext("KiB"), gettext("MiB"), gettext("GiB"),
+          gettext("TiB") };
+  double val = sz;
+  auto it = units.begin();
+  while(val >= 1024.0 && it + 1 != units.end())
+    {
+      val /= 1024.0;
+      it++;
+    }
+  std::stringstream strm;
+  strm.imbue(std::locale("C"));
+  strm << std::fixed << std::setprecision(2) << val;
+  return Glib::ustring(strm.str()) + " " + *it;
+}
+
+Glib::ustring
+CollectionProcessGui::timeString(const double &tm)
+{
+  uint64_t sec = static_cast<uint64_t>(tm + 0.5);
+  std::stringstream strm;
+  strm.imbue(std::locale("C"));
+  strm << sec / 3600 << ":" << std::setw(2) << std::setfill('0')
+       << sec % 3600 / 60 << ":" << std::setw(2) << std::setfill('0')
+       << sec % 60;
+  return Glib::ustring(strm.str());
+}
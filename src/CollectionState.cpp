@@ -0,0 +1,237 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <ByteOrder.h>
+#include <CollectionState.h>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+CollectionState::CollectionState()
+{
+}
+
+bool
+CollectionState::read(const std::filesystem::path &state_path)
+{
+  archives.clear();
+  books_path.clear();
+
+  std::fstream f;
+  f.open(state_path, std::ios_base::in | std::ios_base::binary);
+  if(!f.is_open())
+    {
+      return false;
+    }
+  std::string st;
+  f.seekg(0, std::ios_base::end);
+  st.resize(f.tellg());
+  f.seekg(0, std::ios_base::beg);
+  f.read(st.data(), st.size());
+  f.close();
+
+  ByteOrder bo;
+  uint16_t val16;
+  uint32_t val32;
+  uint64_t val64;
+  size_t pos = 0;
+
+  auto get_str = [&st, &pos, &bo, &val16](std::string &str) {
+    if(pos + sizeof(val16) > st.size())
+      {
+        return false;
+      }
+    std::memcpy(&val16, &st[pos], sizeof(val16));
+    pos += sizeof(val16);
+    bo.set_little(val16);
+    val16 = bo;
+    if(pos + val16 > st.size())
+      {
+        return false;
+      }
+    str = st.substr(pos, val16);
+    pos += val16;
+    return true;
+  };
+
+  std::string str;
+  if(!get_str(str))
+    {
+      return false;
+    }
+  books_path = std::filesystem::u8path(str);
+
+  size_t rec_sz = sizeof(val64) * 3 + sizeof(val32);
+  while(pos < st.size())
+    {
+      std::string rel_path;
+      if(!get_str(rel_path) || pos + rec_sz > st.size())
+        {
+          std::cout << "CollectionState::read error: incorrect file "
+                    << state_path << std::endl;
+          archives.clear();
+          return false;
+        }
+      ArchiveState as;
+      std::memcpy(&val64, &st[pos], sizeof(val64));
+      pos += sizeof(val64);
+      bo.set_little(val64);
+      as.arch_size = bo;
+
+      std::memcpy(&val64, &st[pos], sizeof(val64));
+      pos += sizeof(val64);
+      bo.set_little(val64);
+      val64 = bo;
+      as.arch_mtime = static_cast<int64_t>(val64);
+
+      std::memcpy(&val32, &st[pos], sizeof(val32));
+      pos += sizeof(val32);
+      bo.set_little(val32);
+      as.inp_crc = bo;
+
+      std::memcpy(&val64, &st[pos], sizeof(val64));
+      pos += sizeof(val64);
+      bo.set_little(val64);
+      as.inp_size = bo;
+
+      if(!get_str(as.file_hash))
+        {
+          std::cout << "CollectionState::read error: incorrect file "
+                    << state_path << std::endl;
+          archives.clear();
+          return false;
+        }
+      archives[rel_path] = as;
+    }
+
+  return true;
+}
+
+bool
+CollectionState::write(const std::filesystem::path &state_path,
+                       const std::filesystem::path &books_path,
+                       const std::vector<InpEntry> &entries)
+{
+  std::string st;
+  ByteOrder bo;
+  uint16_t val16;
+  uint32_t val32;
+  uint64_t val64;
+
+  auto add_str = [&st, &bo, &val16](const std::string &str) {
+    val16 = static_cast<uint16_t>(str.size());
+    bo = val16;
+    bo.get_little(val16);
+    st.append(reinterpret_cast<char *>(&val16), sizeof(val16));
+    st += str;
+  };
+
+  add_str(books_path.u8string());
+  for(auto it = entries.begin(); it != entries.end(); it++)
+    {
+      if(it->file_hash.empty())
+        {
+          continue;
+        }
+      add_str(it->arch_path.lexically_relative(books_path).u8string());
+
+      val64 = static_cast<uint64_t>(it->arch_size);
+      bo = val64;
+      bo.get_little(val64);
+      st.append(reinterpret_cast<char *>(&val64), sizeof(val64));
+
+      val64 = static_cast<uint64_t>(mtime(it->arch_mtime));
+      bo = val64;
+      bo.get_little(val64);
+      st.append(reinterpret_cast<char *>(&val64), sizeof(val64));
+
+      val32 = it->inp_crc_known ? it->inp_crc : 0;
+      bo = val32;
+      bo.get_little(val32);
+      st.append(reinterpret_cast<char *>(&val32), sizeof(val32));
+
+      val64 = it->inp_crc_known ? static_cast<uint64_t>(it->entry.size) : 0;
+      bo = val64;
+      bo.get_little(val64);
+      st.append(reinterpret_cast<char *>(&val64), sizeof(val64));
+
+      add_str(it->file_hash);
+    }
+
+  std::filesystem::path tmp = state_path;
+  tmp += std::filesystem::u8path(".new");
+  std::fstream f;
+  f.open(tmp, std::ios_base::out | std::ios_base::binary);
+  if(!f.is_open())
+    {
+      std::cout << "CollectionState::write error: cannot open " << tmp
+                << std::endl;
+      return false;
+    }
+  f.write(st.c_str(), st.size());
+  f.close();
+
+  std::error_code ec;
+  std::filesystem::rename(tmp, state_path, ec);
+  if(ec)
+    {
+      std::cout << "CollectionState::write error: " << ec.message()
+                << std::endl;
+      return false;
+    }
+  return true;
+}
+
+bool
+CollectionState::unchangedArchive(const std::string &rel_path,
+                                  const InpEntry &ie,
+                                  std::string &file_hash) const
+{
+  auto it = archives.find(rel_path);
+  if(it == archives.end())
+    {
+      return false;
+    }
+  if(it->second.arch_size != static_cast<uint64_t>(ie.arch_size)
+     || it->second.arch_mtime != mtime(ie.arch_mtime))
+    {
+      return false;
+    }
+  file_hash = it->second.file_hash;
+  return true;
+}
+
+bool
+CollectionState::unchangedInp(const std::string &rel_path,
+                              const InpEntry &ie) const
+{
+  if(!ie.inp_crc_known)
+    {
+      return false;
+    }
+  auto it = archives.find(rel_path);
+  if(it == archives.end())
+    {
+      return false;
+    }
+  return it->second.inp_crc == ie.inp_crc
+         && it->second.inp_size == static_cast<uint64_t>(ie.entry.size);
+}
+
+int64_t
+CollectionState::mtime(const std::filesystem::file_time_type &tm)
+{
+  return static_cast<int64_t>(tm.time_since_epoch().count());
+}
@@ -0,0 +1,281 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <CollectionWatchGui.h>
+#include <giomm-2.68/giomm/file.h>
+#include <glibmm-2.68/glibmm/datetime.h>
+#include <glibmm-2.68/glibmm/main.h>
+#include <gtkmm-4.0/gtkmm/button.h>
+#include <gtkmm-4.0/gtkmm/grid.h>
+#include <iostream>
+#include <libintl.h>
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+#ifndef USE_OPENMP
+#include <thread>
+#endif
+
+CollectionWatchGui::CollectionWatchGui(Gtk::Window *parent_window,
+                                       const std::shared_ptr<AuxFunc> &af,
+                                       const int &thr_num)
+{
+  this->parent_window = parent_window;
+  this->af = af;
+  this->thr_num = thr_num;
+}
+
+CollectionWatchGui::~CollectionWatchGui()
+{
+  debounce.disconnect();
+  for(auto it = monitors.begin(); it != monitors.end(); it++)
+    {
+      (*it)->cancel();
+    }
+  delete coll_proc;
+  delete finished_disp;
+}
+
+void
+CollectionWatchGui::createWindow(const std::vector<ImportSource> &sources,
+                                 const std::string &coll_name,
+                                 const ImportOptions &options)
+{
+  this->sources = sources;
+  this->coll_name = coll_name;
+  this->options = options;
+
+  finished_disp = new Glib::Dispatcher;
+  finished_disp->connect(
+      std::bind(&CollectionWatchGui::updateFinished, this));
+
+  main_window = new Gtk::Window;
+  main_window->set_application(parent_window->get_application());
+  main_window->set_transient_for(*parent_window);
+  main_window->set_title(gettext("Collection watch"));
+  main_window->set_name("MLwindow");
+  main_window->set_default_size(1, 1);
+
+  Gtk::Grid *grid = Gtk::make_managed<Gtk::Grid>();
+  grid->set_halign(Gtk::Align::FILL);
+  grid->set_valign(Gtk::Align::FILL);
+  main_window->set_child(*grid);
+
+  Gtk::Label *lab = Gtk::make_managed<Gtk::Label>();
+  lab->set_margin(5);
+  lab->set_halign(Gtk::Align::CENTER);
+  lab->set_name("windowLabel");
+  lab->set_text(Glib::ustring(gettext("Watching collection")) + " \""
+                + Glib::ustring(coll_name) + "\"");
+  grid->attach(*lab, 0, 0, 1, 1);
+
+  status = Gtk::make_managed<Gtk::Label>();
+  status->set_margin(5);
+  status->set_halign(Gtk::Align::CENTER);
+  status->set_name("windowLabel");
+  grid->attach(*status, 0, 1, 1, 1);
+
+  Gtk::Button *stop = Gtk::make_managed<Gtk::Button>();
+  stop->set_margin(5);
+  stop->set_halign(Gtk::Align::CENTER);
+  stop->set_name("cancelBut");
+  stop->set_label(gettext("Stop watching"));
+  stop->signal_clicked().connect(std::bind(&Gtk::Window::close, main_window));
+  grid->attach(*stop, 0, 2, 1, 1);
+
+  main_window->signal_close_request().connect(
+      [this] {
+        if(coll_proc)
+          {
+            // Window is closed after current update has been stopped.
+            close_pending = true;
+            coll_proc->stopAll();
+            return true;
+          }
+        std::unique_ptr<Gtk::Window> win(main_window);
+        win->set_visible(false);
+        delete this;
+        return true;
+      },
+      false);
+
+  main_window->present();
+
+  startMonitors();
+
+  // Changes made since last import are applied at once.
+  launchUpdate();
+}
+
+void
+CollectionWatchGui::startMonitors()
+{
+  for(auto it = sources.begin(); it != sources.end(); it++)
+    {
+      try
+        {
+          Glib::RefPtr<Gio::File> fl
+              = Gio::File::create_for_path(it->inpx_path.string());
+          Glib::RefPtr<Gio::FileMonitor> mon = fl->monitor_file();
+          mon->signal_changed().connect(
+              sigc::mem_fun(*this, &CollectionWatchGui::fileChanged));
+          monitors.push_back(mon);
+
+          fl = Gio::File::create_for_path(it->books_path.string());
+          mon = fl->monitor_directory();
+          mon->signal_changed().connect(
+              sigc::mem_fun(*this, &CollectionWatchGui::fileChanged));
+          monitors.push_back(mon);
+
+          // Directory monitors are not recursive, so nested directories
+          // are watched separately.
+          std::error_code ec;
+          for(auto &pp : std::filesystem::recursive_directory_iterator(
+                   it->books_path,
+                   std::filesystem::directory_options::
+                       skip_permission_denied,
+                   ec))
+            {
+              if(!pp.is_directory(ec) || pp.is_symlink(ec))
+                {
+                  continue;
+                }
+              fl = Gio::File::create_for_path(pp.path().string());
+              mon = fl->monitor_directory();
+              mon->signal_changed().connect(
+                  sigc::mem_fun(*this, &CollectionWatchGui::fileChanged));
+              monitors.push_back(mon);
+            }
+        }
+      catch(Glib::Error &er)
+        {
+          std::cout << "CollectionWatchGui::startMonitors error: "
+                    << er.what() << std::endl;
+        }
+    }
+}
+
+void
+CollectionWatchGui::fileChanged(const Glib::RefPtr<Gio::File> &,
+                                const Glib::RefPtr<Gio::File> &,
+                                Gio::FileMonitor::Event event)
+{
+  switch(event)
+    {
+    case Gio::FileMonitor::Event::CHANGED:
+    case Gio::FileMonitor::Event::CHANGES_DONE_HINT:
+    case Gio::FileMonitor::Event::DELETED:
+    case Gio::FileMonitor::Event::CREATED:
+    case Gio::FileMonitor::Event::MOVED:
+    case Gio::FileMonitor::Event::RENAMED:
+    case Gio::FileMonitor::Event::MOVED_IN:
+    case Gio::FileMonitor::Event::MOVED_OUT:
+      break;
+    default:
+      return void();
+    }
+
+  // Burst of changes (copying of big archive for example) results in one
+  // update.
+  debounce.disconnect();
+  debounce = Glib::signal_timeout().connect(
+      std::bind(&CollectionWatchGui::debounceFinished, this),
+      debounce_interval);
+  if(!coll_proc)
+    {
+      status->set_text(gettext("Changes detected, waiting..."));
+    }
+}
+
+bool
+CollectionWatchGui::debounceFinished()
+{
+  if(coll_proc)
+    {
+      changes_pending = true;
+    }
+  else
+    {
+      launchUpdate();
+    }
+  return false;
+}
+
+void
+CollectionWatchGui::launchUpdate()
+{
+  changes_pending = false;
+  updated = false;
+  status->set_text(gettext("Updating collection..."));
+
+  coll_proc = new CollectionProcess(af, thr_num);
+  coll_proc->setOptions(options);
+
+#ifndef USE_OPENMP
+  std::thread work_thr([this] {
+    coll_proc->collectFiles(sources, coll_name);
+    updated = coll_proc->updateBase();
+    finished_disp->emit();
+  });
+  work_thr.detach();
+#endif
+#ifdef USE_OPENMP
+#pragma omp masked
+  {
+    omp_event_handle_t event;
+#pragma omp task detach(event)
+    {
+      coll_proc->collectFiles(sources, coll_name);
+      updated = coll_proc->updateBase();
+      finished_disp->emit();
+      omp_fulfill_event(event);
+    }
+  }
+#endif
+}
+
+void
+CollectionWatchGui::updateFinished()
+{
+  delete coll_proc;
+  coll_proc = nullptr;
+
+  if(close_pending)
+    {
+      // Window and this object are deleted outside of dispatcher handler.
+      Glib::signal_idle().connect_once([this] {
+        main_window->close();
+      });
+      return void();
+    }
+
+  Glib::DateTime tm = Glib::DateTime::create_now_local();
+  if(updated)
+    {
+      status->set_text(Glib::ustring(gettext("Collection updated:")) + " "
+                       + tm.format("%X"));
+    }
+  else
+    {
+      status->set_text(Glib::ustring(gettext("No changes found:")) + " "
+                       + tm.format("%X"));
+    }
+
+  if(changes_pending)
+    {
+      launchUpdate();
+    }
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <DeviceQueues.h>
+#include <chrono>
+#include <fstream>
+
+#ifdef __linux
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+DeviceQueues::DeviceQueues(const int &device_threads)
+{
+  this->device_threads = device_threads;
+}
+
+void
+DeviceQueues::add(const size_t &entry, const std::filesystem::path &arch_path)
+{
+  std::lock_guard<std::mutex> lglock(mtx);
+  std::string id = deviceId(arch_path);
+  auto res = queue_ids.emplace(id, queues.size());
+  if(res.second)
+    {
+      queues.emplace_back();
+    }
+  queues[res.first->second].entries.push_back(entry);
+  remaining++;
+}
+
+bool
+DeviceQueues::next(size_t &entry, size_t &queue,
+                   const std::function<bool()> &canceled)
+{
+  std::unique_lock<std::mutex> ullock(mtx);
+  for(;;)
+    {
+      if(remaining == 0 || (canceled && canceled()))
+        {
+          return false;
+        }
+      // Disk with the smallest number of active archives is taken first,
+      // then disk with more archives left.
+      size_t found = queues.size();
+      for(size_t i = 0; i < queues.size(); i++)
+        {
+          DeviceQueue &q = queues[i];
+          if(q.entries.empty()
+             || (device_threads > 0 && q.active >= device_threads))
+            {
+              continue;
+            }
+          if(found == queues.size() || q.active < queues[found].active
+             || (q.active == queues[found].active
+                 && q.entries.size() > queues[found].entries.size()))
+            {
+              found = i;
+            }
+        }
+      if(found < queues.size())
+        {
+          DeviceQueue &q = queues[found];
+          entry = q.entries.front();
+          q.entries.pop_front();
+          q.active++;
+          remaining--;
+          queue = found;
+          return true;
+        }
+      // Timeout is needed to check cancellation flag.
+      var.wait_for(ullock, std::chrono::milliseconds(100));
+    }
+}
+
+void
+DeviceQueues::release(const size_t &queue)
+{
+  std::lock_guard<std::mutex> lglock(mtx);
+  queues[queue].active--;
+  var.notify_all();
+}
+
+size_t
+DeviceQueues::devicesNumber()
+{
+  std::lock_guard<std::mutex> lglock(mtx);
+  return queues.size();
+}
+
+std::string
+DeviceQueues::deviceId(const std::filesystem::path &arch_path)
+{
+  std::string result;
+#ifdef __linux
+  // stat() follows symbolic links, so archive linked from another disk is
+  // queued to that disk.
+  struct stat st;
+  if(stat(arch_path.c_str(), &st) == 0)
+    {
+      result = diskId(static_cast<uint64_t>(st.st_dev));
+    }
+#endif
+#ifdef _WIN32
+  std::error_code ec;
+  std::filesystem::path p = std::filesystem::canonical(arch_path, ec);
+  if(ec)
+    {
+      p = arch_path;
+    }
+  wchar_t mount_point[MAX_PATH];
+  wchar_t volume[MAX_PATH];
+  if(GetVolumePathNameW(p.wstring().c_str(), mount_point, MAX_PATH)
+     && GetVolumeNameForVolumeMountPointW(mount_point, volume, MAX_PATH))
+    {
+      result = std::filesystem::path(volume).u8string();
+    }
+#endif
+  return result;
+}
+
+#ifdef __linux
+std::string
+DeviceQueues::diskId(const uint64_t &dev)
+{
+  auto it = disks.find(dev);
+  if(it != disks.end())
+    {
+      return it->second;
+    }
+
+  std::string result = std::to_string(major(dev)) + ":"
+                       + std::to_string(minor(dev));
+  // Partition is replaced by disk it belongs to. Devices absent in sysfs
+  // (network and virtual file systems) are taken as they are.
+  std::error_code ec;
+  std::filesystem::path sys_path = std::filesystem::canonical(
+      std::filesystem::u8path("/sys/dev/block") / result, ec);
+  if(!ec
+     && std::filesystem::exists(
+         sys_path / std::filesystem::u8path("partition"), ec))
+    {
+      std::fstream f;
+      f.open(sys_path.parent_path() / std::filesystem::u8path("dev"),
+             std::ios_base::in);
+      std::string disk;
+      if(f.is_open() && std::getline(f, disk) && !disk.empty())
+        {
+          result = disk;
+        }
+    }
+  disks.emplace(dev, result);
+  return result;
+}
+#endif
@@ -0,0 +1,327 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <DirScanner.h>
+#include <iostream>
+#include <memory>
+
+#ifdef __linux
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#ifndef USE_OPENMP
+#include <thread>
+#endif
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
+DirScanner::DirScanner(const int &thr_num)
+{
+  this->thr_num = thr_num;
+  if(this->thr_num < 1)
+    {
+      this->thr_num = 1;
+    }
+}
+
+bool
+DirScanner::scan(
+    const std::vector<std::filesystem::path> &roots,
+    std::unordered_map<std::string, std::filesystem::path> &result,
+    const std::function<bool()> &canceled)
+{
+  this->canceled = canceled;
+  found.clear();
+  found.resize(static_cast<size_t>(thr_num));
+
+#ifndef USE_OPENMP
+  queue.clear();
+  busy = 0;
+  stop = false;
+  for(size_t i = 0; i < roots.size(); i++)
+    {
+      queue.emplace_back(i, 0, roots[i]);
+    }
+  std::vector<std::thread> workers;
+  workers.reserve(found.size());
+  for(size_t i = 0; i < found.size(); i++)
+    {
+      workers.emplace_back(std::thread(&DirScanner::worker, this, i));
+    }
+  for(auto it = workers.begin(); it != workers.end(); it++)
+    {
+      it->join();
+    }
+#endif
+#ifdef USE_OPENMP
+#pragma omp parallel num_threads(thr_num)
+  {
+#pragma omp single
+    {
+      for(size_t i = 0; i < roots.size(); i++)
+        {
+          ScanItem dir(i, 0, roots[i]);
+#pragma omp task firstprivate(dir)
+          scanTask(dir);
+        }
+    }
+  }
+#endif
+
+  if(canceled())
+    {
+      found.clear();
+      return false;
+    }
+
+  // Winner is chosen by precedence rule, so result does not depend on
+  // order of directories processing.
+  std::unordered_map<std::string, ScanItem *> best;
+  for(auto it = found.begin(); it != found.end(); it++)
+    {
+      for(auto it_f = it->begin(); it_f != it->end(); it_f++)
+        {
+          std::string stem = std::get<2>(*it_f).stem().u8string();
+          auto res = best.emplace(stem, &(*it_f));
+          if(!res.second && *it_f < *res.first->second)
+            {
+              res.first->second = &(*it_f);
+            }
+        }
+    }
+  result.reserve(result.size() + best.size());
+  for(auto it = best.begin(); it != best.end(); it++)
+    {
+      result[it->first] = std::move(std::get<2>(*it->second));
+    }
+  found.clear();
+  return true;
+}
+
+#ifndef USE_OPENMP
+void
+DirScanner::worker(const size_t &n)
+{
+  std::vector<ScanItem> subdirs;
+  for(;;)
+    {
+      ScanItem dir;
+      {
+        std::unique_lock<std::mutex> ullock(queue_mtx);
+        queue_var.wait(ullock, [this] {
+          return stop || !queue.empty() || busy == 0;
+        });
+        if(stop || queue.empty())
+          {
+            queue_var.notify_all();
+            break;
+          }
+        dir = std::move(queue.back());
+        queue.pop_back();
+        busy++;
+      }
+
+      subdirs.clear();
+      listDir(dir, subdirs, found[n]);
+
+      std::lock_guard<std::mutex> lglock(queue_mtx);
+      busy--;
+      if(canceled())
+        {
+          stop = true;
+        }
+      for(auto it = subdirs.begin(); it != subdirs.end(); it++)
+        {
+          queue.emplace_back(std::move(*it));
+        }
+      queue_var.notify_all();
+    }
+}
+#endif
+
+#ifdef USE_OPENMP
+void
+DirScanner::scanTask(const ScanItem &dir)
+{
+  if(canceled())
+    {
+      return void();
+    }
+  std::vector<ScanItem> subdirs;
+  listDir(dir, subdirs,
+          found[static_cast<size_t>(omp_get_thread_num())]);
+  for(auto it = subdirs.begin(); it != subdirs.end(); it++)
+    {
+      ScanItem sub = std::move(*it);
+#pragma omp task firstprivate(sub)
+      scanTask(sub);
+    }
+}
+#endif
+
+void
+DirScanner::listDir(const ScanItem &dir, std::vector<ScanItem> &subdirs,
+                    std::vector<ScanItem> &files)
+{
+  const size_t &root = std::get<0>(dir);
+  size_t depth = std::get<1>(dir) + 1;
+  const std::filesystem::path &dir_path = std::get<2>(dir);
+#ifdef __linux
+  // Directory is read by big blocks, entry type is taken from d_type, so
+  // stat() is needed only for links and file systems without d_type.
+  int fd = ::open(dir_path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if(fd < 0)
+    {
+      std::cout << "DirScanner::listDir error: cannot open " << dir_path
+                << std::endl;
+      return void();
+    }
+  size_t buf_sz = 65536;
+  std::unique_ptr<char[]> buf(new char[buf_sz]);
+  for(;;)
+    {
+      long rd = syscall(SYS_getdents64, fd, buf.get(), buf_sz);
+      if(rd <= 0)
+        {
+          if(rd < 0)
+            {
+              std::cout << "DirScanner::listDir error: cannot read "
+                        << dir_path << std::endl;
+            }
+          break;
+        }
+      for(long pos = 0; pos < rd;)
+        {
+          struct dirent64 *ent
+              = reinterpret_cast<struct dirent64 *>(buf.get() + pos);
+          pos += ent->d_reclen;
+          const char *name = ent->d_name;
+          if(name[0] == '.'
+             && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+            {
+              continue;
+            }
+          unsigned char type = ent->d_type;
+          struct stat st;
+          if(type == DT_UNKNOWN)
+            {
+              if(fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+                {
+                  continue;
+                }
+              if(S_ISDIR(st.st_mode))
+                {
+                  type = DT_DIR;
+                }
+              else if(S_ISREG(st.st_mode))
+                {
+                  type = DT_REG;
+                }
+              else if(S_ISLNK(st.st_mode))
+                {
+                  type = DT_LNK;
+                }
+            }
+          if(type == DT_LNK)
+            {
+              if(fstatat(fd, name, &st, 0) != 0 || !S_ISREG(st.st_mode))
+                {
+                  continue;
+                }
+              type = DT_REG;
+            }
+          if(type == DT_DIR)
+            {
+              subdirs.emplace_back(root, depth, dir_path / name);
+            }
+          else if(type == DT_REG)
+            {
+              files.emplace_back(root, depth, dir_path / name);
+            }
+        }
+    }
+  ::close(fd);
+#endif
+#ifdef _WIN32
+  WIN32_FIND_DATAW fd;
+  HANDLE h = FindFirstFileExW((dir_path / L"*").c_str(), FindExInfoBasic,
+                              &fd, FindExSearchNameMatch, nullptr,
+                              FIND_FIRST_EX_LARGE_FETCH);
+  if(h == INVALID_HANDLE_VALUE)
+    {
+      std::cout << "DirScanner::listDir error: cannot open " << dir_path
+                << std::endl;
+      return void();
+    }
+  do
+    {
+      std::wstring name(fd.cFileName);
+      if(name == L"." || name == L"..")
+        {
+          continue;
+        }
+      if(fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        {
+          if(!(fd.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT))
+            {
+              subdirs.emplace_back(root, depth, dir_path / name);
+            }
+        }
+      else
+        {
+          files.emplace_back(root, depth, dir_path / name);
+        }
+    }
+  while(FindNextFileW(h, &fd));
+  FindClose(h);
+#endif
+#if !defined(__linux) && !defined(_WIN32)
+  std::error_code ec;
+  for(auto &pp : std::filesystem::directory_iterator(dir_path, ec))
+    {
+      std::error_code ec_t;
+      if(pp.is_symlink(ec_t))
+        {
+          if(pp.is_regular_file(ec_t))
+            {
+              files.emplace_back(root, depth, pp.path());
+            }
+        }
+      else if(pp.is_directory(ec_t))
+        {
+          subdirs.emplace_back(root, depth, pp.path());
+        }
+      else if(pp.is_regular_file(ec_t))
+        {
+          files.emplace_back(root, depth, pp.path());
+        }
+    }
+  if(ec)
+    {
+      std::cout << "DirScanner::listDir error: " << ec.message()
+                << std::endl;
+    }
+#endif
+}
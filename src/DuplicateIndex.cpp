@@ -0,0 +1,292 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <DuplicateIndex.h>
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iostream>
+
+DuplicateIndex::DuplicateIndex()
+{
+  shards.resize(shards_num);
+#ifndef USE_OPENMP
+  shards_mtx = std::vector<std::mutex>(shards_num);
+#endif
+#ifdef USE_OPENMP
+  shards_mtx.resize(shards_num);
+  for(auto it = shards_mtx.begin(); it != shards_mtx.end(); it++)
+    {
+      omp_init_lock(&(*it));
+    }
+  omp_init_lock(&arch_mtx);
+#endif
+}
+
+DuplicateIndex::~DuplicateIndex()
+{
+#ifdef USE_OPENMP
+  for(auto it = shards_mtx.begin(); it != shards_mtx.end(); it++)
+    {
+      omp_destroy_lock(&(*it));
+    }
+  omp_destroy_lock(&arch_mtx);
+#endif
+}
+
+void
+DuplicateIndex::addArchive(const FileParseEntry &fpe,
+                           const std::vector<BookMeta> &meta,
+                           const std::string &source)
+{
+  uint32_t arch_id = archiveId(fpe.file_rel_path);
+  std::hash<std::string> hasher;
+  std::string key;
+  for(size_t i = 0; i < fpe.books.size() && i < meta.size(); i++)
+    {
+      const BookParseEntry &bpe = fpe.books[i];
+      DuplicateRecord rec;
+      rec.arch_id = arch_id;
+      rec.lib_id = meta[i].lib_id;
+      rec.size = meta[i].size;
+      rec.book_path = bpe.book_path;
+      rec.date = bpe.book_date;
+
+      // Lowest bit of key shows key kind: 1 - LIBID, 0 - folded author,
+      // title and size. LIBID is unique within its source only.
+      if(rec.lib_id > 0)
+        {
+          key = "L" + source;
+          key.push_back('\n');
+          key += std::to_string(rec.lib_id);
+          rec.key = hasher(key) | 1;
+          rec.full_key = key;
+          addRecord(DuplicateRecord(rec));
+        }
+      if(!bpe.book_name.empty())
+        {
+          key = folder.fold(bpe.book_author);
+          key.push_back('\n');
+          key += folder.fold(bpe.book_name);
+          key.push_back('\n');
+          key += std::to_string(meta[i].size);
+          rec.key = hasher(key) & ~static_cast<uint64_t>(1);
+          rec.full_key = std::move(key);
+          addRecord(std::move(rec));
+        }
+    }
+}
+
+size_t
+DuplicateIndex::resolve()
+{
+  removed.clear();
+  removed.resize(arch_names.size());
+  groups.clear();
+
+  size_t result = 0;
+  for(auto it = shards.begin(); it != shards.end(); it++)
+    {
+      // Records are added by threads in any order, so they are sorted
+      // completely to make report the same for every import.
+      std::sort(it->begin(), it->end(),
+                [this](const DuplicateRecord &el1,
+                       const DuplicateRecord &el2) {
+                  if(el1.key != el2.key)
+                    {
+                      return el1.key < el2.key;
+                    }
+                  if(el1.full_key != el2.full_key)
+                    {
+                      return el1.full_key < el2.full_key;
+                    }
+                  if(el1.arch_id != el2.arch_id)
+                    {
+                      return arch_names[el1.arch_id]
+                             < arch_names[el2.arch_id];
+                    }
+                  return el1.book_path < el2.book_path;
+                });
+      for(auto it_b = it->begin(); it_b != it->end();)
+        {
+          auto it_e = it_b + 1;
+          // Records with equal hash sum of different keys are not
+          // duplicates.
+          while(it_e != it->end() && it_e->key == it_b->key
+                && it_e->full_key == it_b->full_key)
+            {
+              it_e++;
+            }
+          if(it_e - it_b > 1)
+            {
+              auto it_n = it_b;
+              for(auto it_g = it_b + 1; it_g != it_e; it_g++)
+                {
+                  if(newer(*it_g, *it_n))
+                    {
+                      it_n = it_g;
+                    }
+                }
+              std::vector<DuplicateRecord> group;
+              group.reserve(it_e - it_b);
+              group.push_back(*it_n);
+              for(auto it_g = it_b; it_g != it_e; it_g++)
+                {
+                  if(it_g->arch_id == it_n->arch_id
+                     && it_g->book_path == it_n->book_path)
+                    {
+                      // The same record from another source.
+                      continue;
+                    }
+                  group.push_back(*it_g);
+                  if(removed[it_g->arch_id].insert(it_g->book_path).second)
+                    {
+                      result++;
+                    }
+                }
+              if(group.size() > 1)
+                {
+                  groups.emplace_back(std::move(group));
+                }
+            }
+          it_b = it_e;
+        }
+      it->clear();
+      it->shrink_to_fit();
+    }
+
+  return result;
+}
+
+bool
+DuplicateIndex::writeReport(const std::filesystem::path &report_path)
+{
+  std::fstream f;
+  f.open(report_path, std::ios_base::out | std::ios_base::binary);
+  if(!f.is_open())
+    {
+      std::cout << "DuplicateIndex::writeReport cannot open " << report_path
+                << std::endl;
+      return false;
+    }
+  for(auto it = groups.begin(); it != groups.end(); it++)
+    {
+      if(it->begin()->key & 1)
+        {
+          f << "LIBID " << it->begin()->lib_id << "\n";
+        }
+      else
+        {
+          f << "AUTHOR, TITLE, SIZE " << it->begin()->size << "\n";
+        }
+      for(auto it_r = it->begin(); it_r != it->end(); it_r++)
+        {
+          if(it_r == it->begin())
+            {
+              f << "+ ";
+            }
+          else
+            {
+              f << "- ";
+            }
+          f << arch_names[it_r->arch_id] << "/" << it_r->book_path << " "
+            << it_r->date << " " << it_r->lib_id << "\n";
+        }
+      f << "\n";
+    }
+  f.close();
+  return true;
+}
+
+size_t
+DuplicateIndex::removeOlder(std::vector<FileParseEntry> &base)
+{
+  size_t result = 0;
+  for(auto it = base.begin(); it != base.end(); it++)
+    {
+      auto it_id = arch_ids.find(it->file_rel_path);
+      if(it_id == arch_ids.end() || removed[it_id->second].empty())
+        {
+          continue;
+        }
+      std::unordered_set<std::string> &rm = removed[it_id->second];
+      size_t sz = it->books.size();
+      it->books.erase(std::remove_if(it->books.begin(), it->books.end(),
+                                     [&rm](BookParseEntry &el) {
+                                       return rm.find(el.book_path)
+                                              != rm.end();
+                                     }),
+                      it->books.end());
+      result += sz - it->books.size();
+    }
+  return result;
+}
+
+uint32_t
+DuplicateIndex::archiveId(const std::string &arch_name)
+{
+  uint32_t result;
+#ifndef USE_OPENMP
+  std::lock_guard<std::mutex> lglock(arch_mtx);
+#endif
+#ifdef USE_OPENMP
+  omp_set_lock(&arch_mtx);
+#endif
+  auto res = arch_ids.emplace(arch_name,
+                              static_cast<uint32_t>(arch_names.size()));
+  if(res.second)
+    {
+      arch_names.push_back(arch_name);
+    }
+  result = res.first->second;
+#ifdef USE_OPENMP
+  omp_unset_lock(&arch_mtx);
+#endif
+  return result;
+}
+
+void
+DuplicateIndex::addRecord(DuplicateRecord &&rec)
+{
+  size_t shard = (rec.key >> 1) % shards_num;
+#ifndef USE_OPENMP
+  std::lock_guard<std::mutex> lglock(shards_mtx[shard]);
+  shards[shard].emplace_back(std::move(rec));
+#endif
+#ifdef USE_OPENMP
+  omp_set_lock(&shards_mtx[shard]);
+  shards[shard].emplace_back(std::move(rec));
+  omp_unset_lock(&shards_mtx[shard]);
+#endif
+}
+
+bool
+DuplicateIndex::newer(const DuplicateRecord &first,
+                      const DuplicateRecord &second)
+{
+  if(first.date != second.date)
+    {
+      return first.date > second.date;
+    }
+  if(first.lib_id != second.lib_id)
+    {
+      return first.lib_id > second.lib_id;
+    }
+  if(first.arch_id != second.arch_id)
+    {
+      return arch_names[first.arch_id] > arch_names[second.arch_id];
+    }
+  return first.book_path > second.book_path;
+}
@@ -0,0 +1,407 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <Fb2Parser.h>
+#include <InpEncoding.h>
+#include <algorithm>
+#include <charconv>
+
+Fb2Parser::Fb2Parser()
+{
+}
+
+bool
+Fb2Parser::description(const std::string &book, BookParseEntry &bpe)
+{
+  std::string::size_type desc_end = book.find("</description>");
+  if(desc_end == std::string::npos)
+    {
+      return false;
+    }
+  std::string desc = book.substr(0, desc_end);
+  toUtf8(book, desc);
+
+  std::string::size_type n = 0;
+  std::string title_info = tagContent(desc, "title-info", n, desc.size());
+  if(title_info.empty())
+    {
+      return false;
+    }
+
+  // Records are built in the same format parseEntry() gives for .inp
+  // records.
+  n = 0;
+  while(n != std::string::npos)
+    {
+      std::string author
+          = authorName(tagContent(title_info, "author", n, title_info.size()));
+      if(!author.empty())
+        {
+          if(!bpe.book_author.empty())
+            {
+              bpe.book_author += ", ";
+            }
+          bpe.book_author += author;
+        }
+    }
+
+  n = 0;
+  while(n != std::string::npos)
+    {
+      std::string genre
+          = text(tagContent(title_info, "genre", n, title_info.size()));
+      if(!genre.empty())
+        {
+          if(!bpe.book_genre.empty())
+            {
+              bpe.book_genre += ", ";
+            }
+          bpe.book_genre += genre;
+        }
+    }
+
+  n = 0;
+  bpe.book_name
+      = text(tagContent(title_info, "book-title", n, title_info.size()));
+
+  n = title_info.find("<sequence");
+  if(n != std::string::npos)
+    {
+      std::string tag = title_info.substr(n, title_info.find(">", n) - n);
+      bpe.book_series = text(attribute(tag, "name"));
+      std::string number = attribute(tag, "number");
+      if(!bpe.book_series.empty() && !number.empty())
+        {
+          bpe.book_series.push_back(series_number_separator);
+          bpe.book_series += number;
+        }
+    }
+
+  // There is no date of addition to library in fb2, date of document
+  // creation is used instead.
+  n = 0;
+  std::string doc_info = tagContent(desc, "document-info", n, desc.size());
+  for(const std::string *info : { &doc_info, &title_info })
+    {
+      n = info->find("<date");
+      if(n == std::string::npos)
+        {
+          continue;
+        }
+      std::string tag = info->substr(n, info->find(">", n) - n);
+      bpe.book_date = attribute(tag, "value");
+      if(bpe.book_date.empty())
+        {
+          bpe.book_date = text(tagContent(*info, "date", n, info->size()));
+        }
+      if(!bpe.book_date.empty())
+        {
+          break;
+        }
+    }
+
+  return !bpe.book_name.empty() || !bpe.book_author.empty();
+}
+
+std::string
+Fb2Parser::tagContent(const std::string &xml, const std::string &tag,
+                      std::string::size_type &n_beg,
+                      std::string::size_type n_lim)
+{
+  std::string open_tag = "<" + tag;
+  std::string close_tag = "</" + tag + ">";
+  for(;;)
+    {
+      n_beg = xml.find(open_tag, n_beg);
+      if(n_beg == std::string::npos || n_beg >= n_lim)
+        {
+          n_beg = std::string::npos;
+          return std::string();
+        }
+      n_beg += open_tag.size();
+      if(n_beg >= xml.size())
+        {
+          n_beg = std::string::npos;
+          return std::string();
+        }
+      char ch = xml[n_beg];
+      if(ch == '>' || ch == '/' || ch == ' ' || ch == '\t' || ch == '\r'
+         || ch == '\n')
+        {
+          break;
+        }
+    }
+  std::string::size_type n_end = xml.find(">", n_beg);
+  if(n_end == std::string::npos)
+    {
+      n_beg = std::string::npos;
+      return std::string();
+    }
+  if(xml[n_end - 1] == '/')
+    {
+      n_beg = n_end + 1;
+      return std::string();
+    }
+  n_end++;
+  std::string::size_type n_close = xml.find(close_tag, n_end);
+  if(n_close == std::string::npos || n_close > n_lim)
+    {
+      n_beg = std::string::npos;
+      return std::string();
+    }
+  n_beg = n_close + close_tag.size();
+
+  // Leading and trailing whitespaces are skipped.
+  while(n_end < n_close && static_cast<unsigned char>(xml[n_end]) <= 32)
+    {
+      n_end++;
+    }
+  while(n_close > n_end && static_cast<unsigned char>(xml[n_close - 1]) <= 32)
+    {
+      n_close--;
+    }
+  return xml.substr(n_end, n_close - n_end);
+}
+
+std::string
+Fb2Parser::attribute(const std::string &tag, const std::string &name)
+{
+  // Attribute can have namespace prefix (l:href, xlink:href).
+  std::string find_str = name + "=";
+  std::string::size_type n = 0;
+  for(;;)
+    {
+      n = tag.find(find_str, n);
+      if(n == std::string::npos)
+        {
+          return std::string();
+        }
+      if(n > 0
+         && (tag[n - 1] == ' ' || tag[n - 1] == ':' || tag[n - 1] == '\t'
+             || tag[n - 1] == '\r' || tag[n - 1] == '\n'))
+        {
+          break;
+        }
+      n += find_str.size();
+    }
+  n += find_str.size();
+  if(n >= tag.size() || (tag[n] != '"' && tag[n] != '\''))
+    {
+      return std::string();
+    }
+  std::string::size_type n_end = tag.find(tag[n], n + 1);
+  if(n_end == std::string::npos)
+    {
+      return std::string();
+    }
+  return tag.substr(n + 1, n_end - n - 1);
+}
+
+void
+Fb2Parser::toUtf8(const std::string &book, std::string &part)
+{
+  InpEncoding enc;
+  std::string decl;
+  std::string::size_type n = book.find("?>");
+  if(n != std::string::npos && book.compare(0, 5, "<?xml") == 0)
+    {
+      decl = book.substr(0, n);
+    }
+  else if(n != std::string::npos
+          && book.compare(0, 8, "\xEF\xBB\xBF<?xml") == 0)
+    {
+      // UTF-8 byte order mark.
+      decl = book.substr(3, n - 3);
+    }
+  std::string name = attribute(decl, "encoding");
+  std::transform(name.begin(), name.end(), name.begin(), [](char el) {
+    if(el >= 'A' && el <= 'Z')
+      {
+        el += 32;
+      }
+    return el;
+  });
+  if(name == "utf-8" || name == "utf8")
+    {
+      enc.transcode(part, InpEncoding::Utf8);
+    }
+  else if(name == "windows-1251" || name == "cp1251")
+    {
+      enc.transcode(part, InpEncoding::Cp1251);
+    }
+  else if(name == "koi8-r")
+    {
+      enc.transcode(part, InpEncoding::Koi8r);
+    }
+  else
+    {
+      enc.toUtf8(part);
+    }
+}
+
+std::string
+Fb2Parser::text(const std::string &xml)
+{
+  std::string result;
+  result.reserve(xml.size());
+  bool space = false;
+  for(std::string::size_type i = 0; i < xml.size(); i++)
+    {
+      char ch = xml[i];
+      if(ch == '<')
+        {
+          std::string::size_type n = xml.find(">", i);
+          if(n == std::string::npos)
+            {
+              break;
+            }
+          i = n;
+          space = true;
+          continue;
+        }
+      if(static_cast<unsigned char>(ch) <= 32)
+        {
+          space = true;
+          continue;
+        }
+      if(space && !result.empty())
+        {
+          result.push_back(' ');
+        }
+      space = false;
+      if(ch != '&')
+        {
+          result.push_back(ch);
+          continue;
+        }
+
+      std::string::size_type n = xml.find(";", i);
+      if(n == std::string::npos || n - i > 10)
+        {
+          result.push_back(ch);
+          continue;
+        }
+      std::string ent = xml.substr(i + 1, n - i - 1);
+      if(ent == "amp")
+        {
+          result.push_back('&');
+        }
+      else if(ent == "lt")
+        {
+          result.push_back('<');
+        }
+      else if(ent == "gt")
+        {
+          result.push_back('>');
+        }
+      else if(ent == "quot")
+        {
+          result.push_back('"');
+        }
+      else if(ent == "apos")
+        {
+          result.push_back('\'');
+        }
+      else if(ent.size() > 1 && ent[0] == '#')
+        {
+          uint32_t cp = 0;
+          std::from_chars_result res;
+          if(ent[1] == 'x' || ent[1] == 'X')
+            {
+              res = std::from_chars(ent.data() + 2, ent.data() + ent.size(),
+                                    cp, 16);
+            }
+          else
+            {
+              res = std::from_chars(ent.data() + 1, ent.data() + ent.size(),
+                                    cp);
+            }
+          if(res.ec != std::errc() || cp == 0 || cp > 0x10FFFF)
+            {
+              result.push_back(ch);
+              continue;
+            }
+          appendCodePoint(result, cp);
+        }
+      else
+        {
+          result.push_back(ch);
+          continue;
+        }
+      i = n;
+    }
+  return result;
+}
+
+std::string
+Fb2Parser::authorName(const std::string &author)
+{
+  std::string result;
+  std::string::size_type n;
+  for(const char *part : { "last-name", "first-name", "middle-name" })
+    {
+      n = 0;
+      std::string name = text(tagContent(author, part, n, author.size()));
+      if(!name.empty())
+        {
+          if(!result.empty())
+            {
+              result.push_back(' ');
+            }
+          result += name;
+        }
+    }
+  if(result.empty())
+    {
+      n = 0;
+      result = text(tagContent(author, "nickname", n, author.size()));
+    }
+  // Commas separate authors in base.
+  for(auto it = result.begin(); it != result.end(); it++)
+    {
+      if(*it == ',')
+        {
+          *it = ' ';
+        }
+    }
+  return result;
+}
+
+void
+Fb2Parser::appendCodePoint(std::string &result, const uint32_t &cp)
+{
+  if(cp < 0x80)
+    {
+      result.push_back(static_cast<char>(cp));
+    }
+  else if(cp < 0x800)
+    {
+      result.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+      result.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+  else if(cp < 0x10000)
+    {
+      result.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+      result.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+      result.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+  else
+    {
+      result.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+      result.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+      result.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+      result.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
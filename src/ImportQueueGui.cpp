@@ -0,0 +1,383 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <ImportQueueGui.h>
+#include <gtkmm-4.0/gtkmm/box.h>
+#include <gtkmm-4.0/gtkmm/scrolledwindow.h>
+#include <libintl.h>
+#include <sstream>
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+#ifndef USE_OPENMP
+#include <thread>
+#endif
+
+ImportJob::ImportJob()
+{
+  state.store(Pending);
+  parsed_bytes.store(0.0);
+  total_size.store(0.0);
+}
+
+ImportJob::~ImportJob()
+{
+  delete coll_proc;
+}
+
+ImportQueueGui::ImportQueueGui(Gtk::Window *parent_window,
+                               const std::shared_ptr<AuxFunc> &af,
+                               const int &thr_num)
+{
+  this->parent_window = parent_window;
+  this->af = af;
+  this->thr_num = thr_num;
+}
+
+ImportQueueGui::~ImportQueueGui()
+{
+  jobs.clear();
+  delete progress_disp;
+}
+
+void
+ImportQueueGui::createWindow()
+{
+  progress_disp = new Glib::Dispatcher;
+  progress_disp->connect(std::bind(&ImportQueueGui::updateJobs, this));
+
+  main_window = new Gtk::Window;
+  main_window->set_application(parent_window->get_application());
+  main_window->set_transient_for(*parent_window);
+  main_window->set_title(gettext("Import queue"));
+  main_window->set_name("MLwindow");
+  main_window->set_default_size(parent_window->get_width(), -1);
+
+  Gtk::Grid *grid = Gtk::make_managed<Gtk::Grid>();
+  grid->set_halign(Gtk::Align::FILL);
+  grid->set_valign(Gtk::Align::FILL);
+  main_window->set_child(*grid);
+
+  Gtk::ScrolledWindow *scrl = Gtk::make_managed<Gtk::ScrolledWindow>();
+  scrl->set_halign(Gtk::Align::FILL);
+  scrl->set_valign(Gtk::Align::FILL);
+  scrl->set_hexpand(true);
+  scrl->set_vexpand(true);
+  scrl->set_min_content_height(200);
+  scrl->set_policy(Gtk::PolicyType::NEVER, Gtk::PolicyType::AUTOMATIC);
+  grid->attach(*scrl, 0, 0, 1, 1);
+
+  jobs_grid = Gtk::make_managed<Gtk::Grid>();
+  jobs_grid->set_halign(Gtk::Align::FILL);
+  jobs_grid->set_valign(Gtk::Align::START);
+  scrl->set_child(*jobs_grid);
+
+  std::stringstream strm;
+  strm.imbue(std::locale("C"));
+  strm << thr_num;
+
+  Gtk::Box *box = Gtk::make_managed<Gtk::Box>(Gtk::Orientation::HORIZONTAL);
+  grid->attach(*box, 0, 1, 1, 1);
+
+  Gtk::Label *lab = Gtk::make_managed<Gtk::Label>();
+  lab->set_margin(5);
+  lab->set_halign(Gtk::Align::START);
+  lab->set_name("windowLabel");
+  lab->set_text(gettext("Threads number for all jobs:"));
+  box->append(*lab);
+
+  thr_budget = Gtk::make_managed<Gtk::Entry>();
+  thr_budget->set_margin(5);
+  thr_budget->set_halign(Gtk::Align::START);
+  thr_budget->set_max_width_chars(3);
+  thr_budget->set_name("windowEntry");
+  thr_budget->set_alignment(Gtk::Align::CENTER);
+  thr_budget->set_text(strm.str());
+  box->append(*thr_budget);
+
+  box = Gtk::make_managed<Gtk::Box>(Gtk::Orientation::HORIZONTAL);
+  grid->attach(*box, 0, 2, 1, 1);
+
+  lab = Gtk::make_managed<Gtk::Label>();
+  lab->set_margin(5);
+  lab->set_halign(Gtk::Align::START);
+  lab->set_name("windowLabel");
+  lab->set_text(gettext("Archives read simultaneously:"));
+  box->append(*lab);
+
+  io_budget = Gtk::make_managed<Gtk::Entry>();
+  io_budget->set_margin(5);
+  io_budget->set_halign(Gtk::Align::START);
+  io_budget->set_max_width_chars(3);
+  io_budget->set_name("windowEntry");
+  io_budget->set_alignment(Gtk::Align::CENTER);
+  io_budget->set_text(strm.str());
+  box->append(*io_budget);
+
+  Gtk::Grid *controls_grid = Gtk::make_managed<Gtk::Grid>();
+  controls_grid->set_halign(Gtk::Align::FILL);
+  controls_grid->set_hexpand(true);
+  controls_grid->set_column_homogeneous(true);
+  grid->attach(*controls_grid, 0, 3, 1, 1);
+
+  start = Gtk::make_managed<Gtk::Button>();
+  start->set_margin(5);
+  start->set_halign(Gtk::Align::CENTER);
+  start->set_name("applyBut");
+  start->set_label(gettext("Start"));
+  start->signal_clicked().connect(
+      std::bind(&ImportQueueGui::startQueue, this));
+  controls_grid->attach(*start, 0, 0, 1, 1);
+
+  Gtk::Button *close = Gtk::make_managed<Gtk::Button>();
+  close->set_margin(5);
+  close->set_halign(Gtk::Align::CENTER);
+  close->set_name("cancelBut");
+  close->set_label(gettext("Close"));
+  close->signal_clicked().connect(std::bind(&Gtk::Window::close, main_window));
+  controls_grid->attach(*close, 1, 0, 1, 1);
+
+  main_window->signal_close_request().connect(
+      [this] {
+        if(running())
+          {
+            return true;
+          }
+        std::unique_ptr<Gtk::Window> win(main_window);
+        win->set_visible(false);
+        if(signal_closed)
+          {
+            signal_closed();
+          }
+        delete this;
+        return true;
+      },
+      false);
+
+  main_window->present();
+}
+
+bool
+ImportQueueGui::addJob(const std::vector<ImportSource> &sources,
+                       const std::string &coll_name,
+                       const ImportOptions &options)
+{
+  for(auto it = jobs.begin(); it != jobs.end(); it++)
+    {
+      if(it->coll_name == coll_name)
+        {
+          return false;
+        }
+    }
+
+  ImportJob &job = jobs.emplace_back();
+  job.sources = sources;
+  job.coll_name = coll_name;
+  job.options = options;
+
+  Gtk::Label *lab = Gtk::make_managed<Gtk::Label>();
+  lab->set_margin(5);
+  lab->set_halign(Gtk::Align::START);
+  lab->set_name("windowLabel");
+  lab->set_text(Glib::ustring(coll_name));
+  jobs_grid->attach(*lab, 0, jobs_rows, 1, 1);
+
+  job.progress = Gtk::make_managed<Gtk::ProgressBar>();
+  job.progress->set_margin(5);
+  job.progress->set_halign(Gtk::Align::FILL);
+  job.progress->set_valign(Gtk::Align::CENTER);
+  job.progress->set_hexpand(true);
+  job.progress->set_name("progressBars");
+  job.progress->set_show_text(true);
+  jobs_grid->attach(*job.progress, 1, jobs_rows, 1, 1);
+
+  job.status = Gtk::make_managed<Gtk::Label>();
+  job.status->set_margin(5);
+  job.status->set_halign(Gtk::Align::START);
+  job.status->set_name("windowLabel");
+  job.status->set_text(gettext("Pending"));
+  jobs_grid->attach(*job.status, 2, jobs_rows, 1, 1);
+
+  job.cancel = Gtk::make_managed<Gtk::Button>();
+  job.cancel->set_margin(5);
+  job.cancel->set_halign(Gtk::Align::CENTER);
+  job.cancel->set_name("cancelBut");
+  job.cancel->set_label(gettext("Cancel"));
+  ImportJob *j = &job;
+  job.cancel->signal_clicked().connect([j] {
+    if(j->coll_proc)
+      {
+        j->coll_proc->stopAll();
+      }
+    else
+      {
+        j->state.store(ImportJob::Interrupted);
+        j->status->set_text(gettext("Operation has been interrupted!"));
+      }
+    j->cancel->set_sensitive(false);
+  });
+  jobs_grid->attach(*job.cancel, 3, jobs_rows, 1, 1);
+
+  jobs_rows++;
+
+  if(scheduler)
+    {
+      startJob(job);
+    }
+
+  return true;
+}
+
+void
+ImportQueueGui::startQueue()
+{
+  start->set_sensitive(false);
+  thr_budget->set_sensitive(false);
+  io_budget->set_sensitive(false);
+
+  thr_num = entryNumber(thr_budget);
+  scheduler = std::make_shared<ImportScheduler>(thr_num,
+                                                entryNumber(io_budget));
+  for(auto it = jobs.begin(); it != jobs.end(); it++)
+    {
+      if(it->state.load() == ImportJob::Pending)
+        {
+          startJob(*it);
+        }
+    }
+}
+
+void
+ImportQueueGui::startJob(ImportJob &job)
+{
+  // Every job may use all threads, ImportScheduler limits total number of
+  // simultaneously processed archives of all jobs.
+  job.coll_proc = new CollectionProcess(af, thr_num);
+  job.coll_proc->setScheduler(scheduler);
+  job.coll_proc->setOptions(job.options);
+  job.state.store(ImportJob::Running);
+  job.status->set_text(gettext("Import progress"));
+
+  ImportJob *j = &job;
+  job.coll_proc->signal_progress
+      = [this, j](const double &pb, const double &ts) {
+          j->parsed_bytes.store(pb);
+          j->total_size.store(ts);
+          progress_disp->emit();
+        };
+
+#ifndef USE_OPENMP
+  std::thread work_thr([this, j] {
+    j->coll_proc->collectFiles(j->sources, j->coll_name);
+    j->coll_proc->createBase();
+    if(j->coll_proc->interrupted())
+      {
+        j->state.store(ImportJob::Interrupted);
+      }
+    else
+      {
+        j->state.store(ImportJob::Completed);
+      }
+    progress_disp->emit();
+  });
+  work_thr.detach();
+#endif
+#ifdef USE_OPENMP
+#pragma omp masked
+  {
+    omp_event_handle_t event;
+#pragma omp task detach(event)
+    {
+      j->coll_proc->collectFiles(j->sources, j->coll_name);
+      j->coll_proc->createBase();
+      if(j->coll_proc->interrupted())
+        {
+          j->state.store(ImportJob::Interrupted);
+        }
+      else
+        {
+          j->state.store(ImportJob::Completed);
+        }
+      progress_disp->emit();
+      omp_fulfill_event(event);
+    }
+  }
+#endif
+}
+
+void
+ImportQueueGui::updateJobs()
+{
+  for(auto it = jobs.begin(); it != jobs.end(); it++)
+    {
+      double ts = it->total_size.load();
+      if(ts > 0.0)
+        {
+          it->progress->set_fraction(it->parsed_bytes.load() / ts);
+        }
+      switch(it->state.load())
+        {
+        case ImportJob::Completed:
+          {
+            it->progress->set_fraction(1.0);
+            it->status->set_text(gettext("All operations completed."));
+            it->cancel->set_sensitive(false);
+            break;
+          }
+        case ImportJob::Interrupted:
+          {
+            it->status->set_text(gettext("Operation has been interrupted!"));
+            it->cancel->set_sensitive(false);
+            break;
+          }
+        default:
+          break;
+        }
+    }
+}
+
+bool
+ImportQueueGui::running()
+{
+  for(auto it = jobs.begin(); it != jobs.end(); it++)
+    {
+      if(it->state.load() == ImportJob::Running)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+int
+ImportQueueGui::entryNumber(Gtk::Entry *entry)
+{
+  std::stringstream strm;
+  strm.imbue(std::locale("C"));
+  std::string str = entry->get_text();
+  if(str.empty())
+    {
+      str = "1";
+    }
+  strm.str(str);
+  int num;
+  strm >> num;
+  if(num <= 0)
+    {
+      num = 1;
+    }
+  return num;
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <ImportScheduler.h>
+#include <algorithm>
+#include <chrono>
+
+ImportScheduler::ImportScheduler(const int &thr_budget, const int &io_budget)
+{
+  this->thr_budget = thr_budget;
+  if(this->thr_budget < 1)
+    {
+      this->thr_budget = 1;
+    }
+  this->io_budget = io_budget;
+  if(this->io_budget < 1)
+    {
+      this->io_budget = 1;
+    }
+}
+
+bool
+ImportScheduler::acquireThread(const std::function<bool()> &canceled)
+{
+  return acquire(thr_used, thr_budget, canceled);
+}
+
+void
+ImportScheduler::releaseThread()
+{
+  release(thr_used);
+}
+
+int
+ImportScheduler::tryAcquireThreads(const int &number)
+{
+  std::lock_guard<std::mutex> lglock(mtx);
+  int result = std::min(number, thr_budget - thr_used);
+  if(result < 0)
+    {
+      result = 0;
+    }
+  thr_used += result;
+  return result;
+}
+
+void
+ImportScheduler::releaseThreads(const int &number)
+{
+  if(number < 1)
+    {
+      return void();
+    }
+  std::lock_guard<std::mutex> lglock(mtx);
+  thr_used -= number;
+  var.notify_all();
+}
+
+bool
+ImportScheduler::acquireIo(const std::function<bool()> &canceled)
+{
+  return acquire(io_used, io_budget, canceled);
+}
+
+void
+ImportScheduler::releaseIo()
+{
+  release(io_used);
+}
+
+void
+ImportScheduler::wakeAll()
+{
+  std::lock_guard<std::mutex> lglock(mtx);
+  var.notify_all();
+}
+
+bool
+ImportScheduler::acquire(int &used, const int &budget,
+                         const std::function<bool()> &canceled)
+{
+  std::unique_lock<std::mutex> ullock(mtx);
+  for(;;)
+    {
+      if(canceled && canceled())
+        {
+          return false;
+        }
+      if(used < budget)
+        {
+          used++;
+          return true;
+        }
+      // Timeout is needed to check cancellation flag even if nobody has
+      // called wakeAll().
+      var.wait_for(ullock, std::chrono::milliseconds(100));
+    }
+}
+
+void
+ImportScheduler::release(int &used)
+{
+  std::lock_guard<std::mutex> lglock(mtx);
+  used--;
+  var.notify_all();
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <ByteOrder.h>
+#include <IndexReader.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+IndexReader::IndexReader()
+{
+}
+
+bool
+IndexReader::open(const std::filesystem::path &index_path)
+{
+  data.clear();
+  directory.clear();
+
+  std::fstream f;
+  f.open(index_path, std::ios_base::in | std::ios_base::binary);
+  if(!f.is_open())
+    {
+      return false;
+    }
+  f.seekg(0, std::ios_base::end);
+  data.resize(f.tellg());
+  f.seekg(0, std::ios_base::beg);
+  f.read(data.data(), data.size());
+  f.close();
+
+  std::string magic = "MLIDX";
+  magic.push_back(1);
+  size_t pos = magic.size();
+  if(data.size() < pos + sizeof(uint64_t) || data.compare(0, pos, magic) != 0)
+    {
+      std::cout << "IndexReader::open error: incorrect file " << index_path
+                << std::endl;
+      data.clear();
+      return false;
+    }
+  uint64_t keys_num = get64(pos);
+  pos += sizeof(uint64_t);
+
+  ByteOrder bo;
+  uint16_t val16;
+  directory.reserve(std::min(keys_num, static_cast<uint64_t>(data.size())));
+  for(uint64_t i = 0; i < keys_num; i++)
+    {
+      if(pos + sizeof(val16) > data.size())
+        {
+          break;
+        }
+      std::memcpy(&val16, &data[pos], sizeof(val16));
+      pos += sizeof(val16);
+      bo.set_little(val16);
+      val16 = bo;
+      if(pos + val16 + sizeof(uint64_t) > data.size())
+        {
+          break;
+        }
+      std::string key = data.substr(pos, val16);
+      pos += val16;
+      uint64_t offsets_num = get64(pos);
+      if(offsets_num > (data.size() - pos) / sizeof(uint64_t) - 1)
+        {
+          break;
+        }
+      directory.emplace_back(std::make_pair(std::move(key), pos));
+      pos += sizeof(uint64_t) * (offsets_num + 1);
+    }
+  if(directory.size() != keys_num || pos != data.size())
+    {
+      std::cout << "IndexReader::open error: incorrect file " << index_path
+                << std::endl;
+      data.clear();
+      directory.clear();
+      return false;
+    }
+
+  return true;
+}
+
+std::vector<std::string>
+IndexReader::keys() const
+{
+  std::vector<std::string> result;
+  result.reserve(directory.size());
+  for(auto it = directory.begin(); it != directory.end(); it++)
+    {
+      result.push_back(it->first);
+    }
+  return result;
+}
+
+bool
+IndexReader::find(const std::string &key,
+                  std::vector<uint64_t> &offsets) const
+{
+  auto it = std::lower_bound(
+      directory.begin(), directory.end(), key,
+      [](const std::pair<std::string, size_t> &el, const std::string &key) {
+        return el.first < key;
+      });
+  if(it == directory.end() || it->first != key)
+    {
+      return false;
+    }
+  size_t pos = it->second;
+  uint64_t offsets_num = get64(pos);
+  offsets.reserve(offsets.size() + offsets_num);
+  for(uint64_t i = 1; i <= offsets_num; i++)
+    {
+      offsets.push_back(get64(pos + i * sizeof(uint64_t)));
+    }
+  return true;
+}
+
+uint64_t
+IndexReader::get64(const size_t &pos) const
+{
+  uint64_t val64;
+  std::memcpy(&val64, &data[pos], sizeof(val64));
+  ByteOrder bo;
+  bo.set_little(val64);
+  val64 = bo;
+  return val64;
+}
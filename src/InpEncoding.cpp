@@ -0,0 +1,381 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <InpEncoding.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// Code points of bytes 0x80-0xFF. Undefined bytes are mapped to U+FFFD.
+static const uint16_t cp1251_table[128] = {
+  0x0402, 0x0403, 0x201A, 0x0453, 0x201E, 0x2026, 0x2020, 0x2021,
+  0x20AC, 0x2030, 0x0409, 0x2039, 0x040A, 0x040C, 0x040B, 0x040F,
+  0x0452, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+  0xFFFD, 0x2122, 0x0459, 0x203A, 0x045A, 0x045C, 0x045B, 0x045F,
+  0x00A0, 0x040E, 0x045E, 0x0408, 0x00A4, 0x0490, 0x00A6, 0x00A7,
+  0x0401, 0x00A9, 0x0404, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x0407,
+  0x00B0, 0x00B1, 0x0406, 0x0456, 0x0491, 0x00B5, 0x00B6, 0x00B7,
+  0x0451, 0x2116, 0x0454, 0x00BB, 0x0458, 0x0405, 0x0455, 0x0457,
+  0x0410, 0x0411, 0x0412, 0x0413, 0x0414, 0x0415, 0x0416, 0x0417,
+  0x0418, 0x0419, 0x041A, 0x041B, 0x041C, 0x041D, 0x041E, 0x041F,
+  0x0420, 0x0421, 0x0422, 0x0423, 0x0424, 0x0425, 0x0426, 0x0427,
+  0x0428, 0x0429, 0x042A, 0x042B, 0x042C, 0x042D, 0x042E, 0x042F,
+  0x0430, 0x0431, 0x0432, 0x0433, 0x0434, 0x0435, 0x0436, 0x0437,
+  0x0438, 0x0439, 0x043A, 0x043B, 0x043C, 0x043D, 0x043E, 0x043F,
+  0x0440, 0x0441, 0x0442, 0x0443, 0x0444, 0x0445, 0x0446, 0x0447,
+  0x0448, 0x0449, 0x044A, 0x044B, 0x044C, 0x044D, 0x044E, 0x044F,
+};
+
+static const uint16_t koi8r_table[128] = {
+  0x2500, 0x2502, 0x250C, 0x2510, 0x2514, 0x2518, 0x251C, 0x2524,
+  0x252C, 0x2534, 0x253C, 0x2580, 0x2584, 0x2588, 0x258C, 0x2590,
+  0x2591, 0x2592, 0x2593, 0x2320, 0x25A0, 0x2219, 0x221A, 0x2248,
+  0x2264, 0x2265, 0x00A0, 0x2321, 0x00B0, 0x00B2, 0x00B7, 0x00F7,
+  0x2550, 0x2551, 0x2552, 0x0451, 0x2553, 0x2554, 0x2555, 0x2556,
+  0x2557, 0x2558, 0x2559, 0x255A, 0x255B, 0x255C, 0x255D, 0x255E,
+  0x255F, 0x2560, 0x2561, 0x0401, 0x2562, 0x2563, 0x2564, 0x2565,
+  0x2566, 0x2567, 0x2568, 0x2569, 0x256A, 0x256B, 0x256C, 0x00A9,
+  0x044E, 0x0430, 0x0431, 0x0446, 0x0434, 0x0435, 0x0444, 0x0433,
+  0x0445, 0x0438, 0x0439, 0x043A, 0x043B, 0x043C, 0x043D, 0x043E,
+  0x043F, 0x044F, 0x0440, 0x0441, 0x0442, 0x0443, 0x0436, 0x0432,
+  0x044C, 0x044B, 0x0437, 0x0448, 0x044D, 0x0449, 0x0447, 0x044A,
+  0x042E, 0x0410, 0x0411, 0x0426, 0x0414, 0x0415, 0x0424, 0x0413,
+  0x0425, 0x0418, 0x0419, 0x041A, 0x041B, 0x041C, 0x041D, 0x041E,
+  0x041F, 0x042F, 0x0420, 0x0421, 0x0422, 0x0423, 0x0416, 0x0412,
+  0x042C, 0x042B, 0x0417, 0x0428, 0x042D, 0x0429, 0x0427, 0x042A,
+};
+
+InpEncoding::InpEncoding()
+{
+}
+
+InpEncoding::Encoding
+InpEncoding::toUtf8(std::string &buf)
+{
+  if(validUtf8(buf))
+    {
+      return Encoding::Utf8;
+    }
+
+  // Single broken sequence (for example truncated field) must not make
+  // UTF-8 text look like CP1251 or KOI8-R, so every line is decided
+  // separately.
+  std::vector<std::string_view> lines;
+  std::vector<bool> legacy;
+  size_t lower_half = 0;
+  size_t upper_half = 0;
+  std::string_view rest(buf);
+  while(!rest.empty())
+    {
+      std::string_view line = rest.substr(0, rest.find('\n'));
+      if(line.size() < rest.size())
+        {
+          line = rest.substr(0, line.size() + 1);
+        }
+      rest.remove_prefix(line.size());
+      size_t valid;
+      size_t invalid;
+      size_t lower;
+      size_t upper;
+      scan(line, valid, invalid, lower, upper);
+      lines.push_back(line);
+      legacy.push_back(invalid > valid);
+      if(legacy.back())
+        {
+          lower_half += lower;
+          upper_half += upper;
+        }
+    }
+
+  // Russian text consists mostly of lowercase letters. They are in range
+  // 0xE0-0xFF in CP1251 and in range 0xC0-0xDF in KOI8-R.
+  Encoding enc = Encoding::Utf8;
+  const uint16_t *table = cp1251_table;
+  if(std::find(legacy.begin(), legacy.end(), true) != legacy.end())
+    {
+      enc = Encoding::Cp1251;
+      if(lower_half > upper_half)
+        {
+          enc = Encoding::Koi8r;
+          table = koi8r_table;
+        }
+    }
+
+  std::string result;
+  result.reserve(buf.size() + buf.size() / 2);
+  for(size_t i = 0; i < lines.size(); i++)
+    {
+      if(legacy[i])
+        {
+          appendTranscoded(result, lines[i], table);
+        }
+      else
+        {
+          appendUtf8(result, lines[i]);
+        }
+    }
+  buf = std::move(result);
+
+  return enc;
+}
+
+bool
+InpEncoding::validUtf8(const std::string_view &buf)
+{
+  const unsigned char *data
+      = reinterpret_cast<const unsigned char *>(buf.data());
+  size_t size = buf.size();
+  size_t i = 0;
+  while(i < size)
+    {
+      i += asciiPrefix(buf.data() + i, size - i);
+      if(i >= size)
+        {
+          break;
+        }
+      size_t len = sequenceLength(data + i, size - i);
+      if(len == 0)
+        {
+          return false;
+        }
+      i += len;
+    }
+  return true;
+}
+
+InpEncoding::Encoding
+InpEncoding::detect(const std::string_view &buf)
+{
+  size_t valid;
+  size_t invalid;
+  size_t lower_half;
+  size_t upper_half;
+  scan(buf, valid, invalid, lower_half, upper_half);
+  // Text dominated by valid sequences (for example Cyrillic letters with
+  // lead bytes 0xD0 and 0xD1) is UTF-8.
+  if(valid >= invalid)
+    {
+      return Encoding::Utf8;
+    }
+  if(lower_half > upper_half)
+    {
+      return Encoding::Koi8r;
+    }
+  return Encoding::Cp1251;
+}
+
+void
+InpEncoding::transcode(std::string &buf, const Encoding &enc)
+{
+  const uint16_t *table;
+  switch(enc)
+    {
+    case Encoding::Cp1251:
+      {
+        table = cp1251_table;
+        break;
+      }
+    case Encoding::Koi8r:
+      {
+        table = koi8r_table;
+        break;
+      }
+    default:
+      {
+        // Invalid bytes of UTF-8 text are replaced by U+FFFD.
+        if(validUtf8(buf))
+          {
+            return void();
+          }
+        std::string result;
+        result.reserve(buf.size() + buf.size() / 2);
+        appendUtf8(result, buf);
+        buf = std::move(result);
+        return void();
+      }
+    }
+
+  std::string result;
+  result.reserve(buf.size() + buf.size() / 2);
+  appendTranscoded(result, buf, table);
+  buf = std::move(result);
+}
+
+void
+InpEncoding::scan(const std::string_view &buf, size_t &valid,
+                  size_t &invalid, size_t &lower_half, size_t &upper_half)
+{
+  valid = 0;
+  invalid = 0;
+  lower_half = 0;
+  upper_half = 0;
+  const unsigned char *data
+      = reinterpret_cast<const unsigned char *>(buf.data());
+  size_t size = buf.size();
+  size_t i = 0;
+  while(i < size)
+    {
+      i += asciiPrefix(buf.data() + i, size - i);
+      if(i >= size)
+        {
+          break;
+        }
+      size_t len = sequenceLength(data + i, size - i);
+      if(len > 0)
+        {
+          valid++;
+          i += len;
+          continue;
+        }
+      invalid++;
+      if(data[i] >= 0xE0)
+        {
+          upper_half++;
+        }
+      else if(data[i] >= 0xC0)
+        {
+          lower_half++;
+        }
+      i++;
+    }
+}
+
+size_t
+InpEncoding::sequenceLength(const unsigned char *data, const size_t &size)
+{
+  unsigned char c = data[0];
+  size_t len;
+  uint32_t cp;
+  if(c >= 0xC2 && c <= 0xDF)
+    {
+      len = 2;
+      cp = c & 0x1F;
+    }
+  else if(c >= 0xE0 && c <= 0xEF)
+    {
+      len = 3;
+      cp = c & 0x0F;
+    }
+  else if(c >= 0xF0 && c <= 0xF4)
+    {
+      len = 4;
+      cp = c & 0x07;
+    }
+  else
+    {
+      return 0;
+    }
+  if(size < len)
+    {
+      return 0;
+    }
+  for(size_t j = 1; j < len; j++)
+    {
+      if((data[j] & 0xC0) != 0x80)
+        {
+          return 0;
+        }
+      cp = (cp << 6) | (data[j] & 0x3F);
+    }
+  // Overlong forms, surrogates and code points above U+10FFFF.
+  if((len == 3 && cp < 0x800) || (len == 4 && cp < 0x10000)
+     || (cp >= 0xD800 && cp <= 0xDFFF) || cp > 0x10FFFF)
+    {
+      return 0;
+    }
+  return len;
+}
+
+void
+InpEncoding::appendUtf8(std::string &result, const std::string_view &buf)
+{
+  const unsigned char *data
+      = reinterpret_cast<const unsigned char *>(buf.data());
+  size_t size = buf.size();
+  size_t i = 0;
+  while(i < size)
+    {
+      size_t n = asciiPrefix(buf.data() + i, size - i);
+      if(n == 0)
+        {
+          n = sequenceLength(data + i, size - i);
+        }
+      if(n > 0)
+        {
+          result.append(buf.data() + i, n);
+          i += n;
+          continue;
+        }
+      // U+FFFD
+      result.append("\xEF\xBF\xBD");
+      i++;
+    }
+}
+
+void
+InpEncoding::appendTranscoded(std::string &result,
+                              const std::string_view &buf,
+                              const uint16_t *table)
+{
+  size_t size = buf.size();
+  size_t i = 0;
+  while(i < size)
+    {
+      size_t n = asciiPrefix(buf.data() + i, size - i);
+      if(n > 0)
+        {
+          result.append(buf.data() + i, n);
+          i += n;
+          continue;
+        }
+
+      uint16_t cp = table[static_cast<unsigned char>(buf[i]) - 0x80];
+      if(cp < 0x800)
+        {
+          result.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+          result.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+      else
+        {
+          result.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+          result.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+          result.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+      i++;
+    }
+}
+
+size_t
+InpEncoding::asciiPrefix(const char *data, const size_t &size)
+{
+  // Eight bytes are checked at once, so ASCII text is passed at memory
+  // speed.
+  size_t i = 0;
+  uint64_t word;
+  while(size - i >= sizeof(word))
+    {
+      std::memcpy(&word, data + i, sizeof(word));
+      if(word & 0x8080808080808080ULL)
+        {
+          break;
+        }
+      i += sizeof(word);
+    }
+  while(i < size && static_cast<unsigned char>(data[i]) < 0x80)
+    {
+      i++;
+    }
+  return i;
+}
@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <InpParser.h>
+#include <algorithm>
+#include <charconv>
+
+InpParser::InpParser()
+{
+}
+
+void
+InpParser::parseChunk(const std::string_view &fl_str,
+                      const std::string::size_type &beg,
+                      const std::string::size_type &end,
+                      std::vector<BookParseEntry> &books,
+                      std::vector<BookMeta> &meta,
+                      const std::function<bool()> &canceled)
+{
+  std::string find_str = { 0x0d, 0x0a };
+  std::string::size_type n_beg = beg;
+  std::string::size_type n_end = beg;
+
+  // Record vectors are reserved for all lines of chunk at once.
+  size_t lines = static_cast<size_t>(
+      std::count(fl_str.begin() + beg, fl_str.begin() + end, '\n'));
+  books.reserve(books.size() + lines);
+  meta.reserve(meta.size() + lines);
+
+  for(;;)
+    {
+      if(canceled())
+        {
+          break;
+        }
+      n_end = fl_str.find(find_str, n_beg);
+      if(n_end != std::string::npos && n_end < end)
+        {
+          parseEntry(fl_str.substr(n_beg, n_end - n_beg), books, meta);
+        }
+      else
+        {
+          break;
+        }
+      n_beg = n_end + find_str.size();
+      if(n_beg >= end)
+        {
+          break;
+        }
+    }
+}
+
+void
+InpParser::parseEntry(const std::string_view &ent,
+                      std::vector<BookParseEntry> &books,
+                      std::vector<BookMeta> &meta)
+{
+  // Fields are assigned from .inp buffer directly, so every string is
+  // allocated once at most (short strings are not allocated at all).
+  books.emplace_back();
+  BookParseEntry &bpe = books.back();
+  BookMeta bm;
+  std::string::size_type n_beg = 0;
+  std::string::size_type n_end = 0;
+  char sep = 0x04;
+  std::string_view field;
+  std::string_view s_nm;
+  std::string_view ext;
+  for(int i = 1; i <= 11; i++)
+    {
+      n_end = ent.find(sep, n_beg);
+      if(n_end != std::string::npos)
+        {
+          field = ent.substr(n_beg, n_end - n_beg);
+          switch(i)
+            {
+            case 1:
+              {
+                parseNames(field, scratch, true);
+                bpe.book_author = scratch;
+                break;
+              }
+            case 2:
+              {
+                parseNames(field, scratch, false);
+                bpe.book_genre = scratch;
+                break;
+              }
+            case 3:
+              {
+                bpe.book_name = field;
+                break;
+              }
+            case 4:
+              {
+                bpe.book_series = field;
+                break;
+              }
+            case 5:
+              {
+                s_nm = field;
+                break;
+              }
+            case 6:
+              {
+                bpe.book_path = field;
+                break;
+              }
+            case 7:
+              {
+                std::from_chars(field.data(), field.data() + field.size(),
+                                bm.size);
+                break;
+              }
+            case 8:
+              {
+                std::from_chars(field.data(), field.data() + field.size(),
+                                bm.lib_id);
+                break;
+              }
+            case 10:
+              {
+                ext = field;
+                break;
+              }
+            case 11:
+              {
+                bpe.book_date = field;
+                break;
+              }
+            default:
+              break;
+            }
+        }
+      else
+        {
+          break;
+        }
+      n_beg = n_end + 1;
+      if(n_beg >= ent.size())
+        {
+          break;
+        }
+    }
+  if(!s_nm.empty())
+    {
+      bpe.book_series.reserve(bpe.book_series.size() + 1 + s_nm.size());
+      bpe.book_series.push_back(series_number_separator);
+      bpe.book_series.append(s_nm);
+    }
+  if(!ext.empty())
+    {
+      bpe.book_path.reserve(bpe.book_path.size() + 1 + ext.size());
+      bpe.book_path.push_back('.');
+      bpe.book_path.append(ext);
+    }
+  meta.push_back(bm);
+}
+
+void
+InpParser::parseNames(const std::string_view &field, std::string &result,
+                      const bool &trim)
+{
+  // Whitespaces are removed, trailing ':' is dropped, ',' becomes space
+  // and ':' becomes ", " (one space before it is removed).
+  result.clear();
+  std::string_view::size_type end = field.size();
+  while(end > 0 && static_cast<unsigned char>(field[end - 1]) <= 32)
+    {
+      end--;
+    }
+  if(end > 0 && field[end - 1] == ':')
+    {
+      end--;
+    }
+  for(std::string_view::size_type i = 0; i < end; i++)
+    {
+      char ch = field[i];
+      if(static_cast<unsigned char>(ch) <= 32)
+        {
+          continue;
+        }
+      switch(ch)
+        {
+        case ',':
+          {
+            result.push_back(' ');
+            break;
+          }
+        case ':':
+          {
+            if(!result.empty() && result.back() == ' ')
+              {
+                result.pop_back();
+              }
+            result.push_back(',');
+            result.push_back(' ');
+            break;
+          }
+        default:
+          {
+            result.push_back(ch);
+            break;
+          }
+        }
+    }
+
+  if(trim)
+    {
+      std::string::size_type beg = 0;
+      while(beg < result.size()
+            && static_cast<unsigned char>(result[beg]) <= 32)
+        {
+          beg++;
+        }
+      while(result.size() > beg
+            && static_cast<unsigned char>(result.back()) <= 32)
+        {
+          result.pop_back();
+        }
+      result.erase(0, beg);
+    }
+}
@@ -0,0 +1,527 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <ByteOrder.h>
+#include <InpxCache.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <tuple>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <process.h>
+#endif
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+InpxCache::InpxCache()
+{
+#ifdef USE_OPENMP
+  omp_init_lock(&added_mtx);
+#endif
+}
+
+InpxCache::~InpxCache()
+{
+#ifdef USE_OPENMP
+  omp_destroy_lock(&added_mtx);
+#endif
+}
+
+bool
+InpxCache::open(const std::filesystem::path &cache_dir,
+                const std::string &key)
+{
+  if(key.empty())
+    {
+      return false;
+    }
+  this->cache_dir = cache_dir;
+  cache_path = cache_dir / std::filesystem::u8path(key + ".inpxc");
+
+  std::error_code ec;
+  if(!std::filesystem::exists(cache_path, ec))
+    {
+      return false;
+    }
+  mapped = std::make_unique<MappedFile>();
+  if(!mapped->open(cache_path))
+    {
+      mapped.reset();
+      return false;
+    }
+  data = mapped->data();
+
+  std::string magic = "MLIC";
+  magic.push_back(3);
+  size_t pos = magic.size();
+  bool correct = data.size() >= pos + 3 * sizeof(uint64_t)
+                 && data.substr(0, pos) == magic;
+  if(correct)
+    {
+      inp_num = get64(data, pos);
+      records_num = get64(data, pos + sizeof(uint64_t));
+      uint64_t strings_sz = get64(data, pos + 2 * sizeof(uint64_t));
+      records_pos = pos + 3 * sizeof(uint64_t);
+      uint64_t rest = data.size() - records_pos;
+      correct = inp_num <= rest / 40;
+      if(correct)
+        {
+          rest -= inp_num * 40;
+          records_pos += inp_num * 40;
+          correct = records_num <= rest / 88
+                    && rest - records_num * 88 == strings_sz;
+          strings_pos = records_pos + records_num * 88;
+        }
+    }
+  if(!correct)
+    {
+      std::cout << "InpxCache::open error: incorrect file " << cache_path
+                << std::endl;
+      data = std::string_view();
+      mapped.reset();
+      inp_num = 0;
+      records_num = 0;
+      return false;
+    }
+
+  // Modification time shows when cache was used last time.
+  std::filesystem::last_write_time(
+      cache_path, std::filesystem::file_time_type::clock::now(), ec);
+  return true;
+}
+
+bool
+InpxCache::find(const std::string &inp_name,
+                std::vector<BookParseEntry> &books,
+                std::vector<BookMeta> &meta) const
+{
+  size_t beg = 0;
+  size_t end = static_cast<size_t>(inp_num);
+  std::string_view name;
+  uint64_t first = 0;
+  uint64_t num = 0;
+  uint64_t sum = 0;
+  while(beg < end)
+    {
+      size_t mid = beg + (end - beg) / 2;
+      if(!inpEntry(mid, name, first, num, sum))
+        {
+          return false;
+        }
+      if(name < inp_name)
+        {
+          beg = mid + 1;
+        }
+      else
+        {
+          end = mid;
+        }
+    }
+  if(beg == inp_num || !inpEntry(beg, name, first, num, sum)
+     || name != inp_name)
+    {
+      return false;
+    }
+
+  std::string_view strings = data.substr(strings_pos);
+  size_t books_sz = books.size();
+  books.reserve(books_sz + num);
+  meta.reserve(meta.size() + num);
+  uint64_t check = 14695981039346656037ULL;
+  for(uint64_t i = first; i < first + num; i++)
+    {
+      size_t pos = records_pos + static_cast<size_t>(i) * 88;
+      std::string_view fields[6];
+      for(size_t j = 0; j < 6; j++)
+        {
+          uint64_t off = get64(data, pos + j * 12);
+          uint32_t sz = get32(data, pos + j * 12 + sizeof(uint64_t));
+          if(off > strings.size() || sz > strings.size() - off)
+            {
+              books.resize(books_sz);
+              meta.resize(books_sz);
+              return false;
+            }
+          fields[j] = strings.substr(off, sz);
+          addChecksum(check, sz, sizeof(sz));
+          addChecksum(check, fields[j]);
+        }
+      BookParseEntry &bpe = books.emplace_back();
+      bpe.book_path = fields[0];
+      bpe.book_author = fields[1];
+      bpe.book_name = fields[2];
+      bpe.book_series = fields[3];
+      bpe.book_genre = fields[4];
+      bpe.book_date = fields[5];
+      BookMeta &bm = meta.emplace_back();
+      bm.size = get64(data, pos + 72);
+      bm.lib_id = get64(data, pos + 80);
+      addChecksum(check, bm.size, sizeof(bm.size));
+      addChecksum(check, bm.lib_id, sizeof(bm.lib_id));
+    }
+  if(check != sum)
+    {
+      std::cout << "InpxCache::find error: wrong checksum of " << inp_name
+                << std::endl;
+      books.resize(books_sz);
+      meta.resize(books_sz);
+      return false;
+    }
+  return true;
+}
+
+void
+InpxCache::add(const std::string &inp_name,
+               const std::vector<BookParseEntry> &books,
+               const std::vector<BookMeta> &meta)
+{
+  if(cache_path.empty())
+    {
+      return void();
+    }
+  // Records are converted to format of cache file before lock is taken, so
+  // threads do not wait for each other and parsed records are not copied.
+  InpxCacheEntry ent;
+  ent.num = static_cast<uint64_t>(books.size());
+  ent.sum = 14695981039346656037ULL;
+  std::unordered_map<std::string_view, uint64_t> string_offsets;
+  auto add_str = [&ent, &string_offsets, this](const std::string_view &str) {
+    addChecksum(ent.sum, static_cast<uint32_t>(str.size()), sizeof(uint32_t));
+    addChecksum(ent.sum, str);
+    auto res = string_offsets.emplace(str, ent.strings.size());
+    if(res.second)
+      {
+        ent.strings.append(str);
+      }
+    put64(ent.records, res.first->second);
+    put32(ent.records, static_cast<uint32_t>(str.size()));
+  };
+  ent.records.reserve(books.size() * 88);
+  for(size_t i = 0; i < books.size(); i++)
+    {
+      const BookParseEntry &bpe = books[i];
+      add_str(bpe.book_path);
+      add_str(bpe.book_author);
+      add_str(bpe.book_name);
+      add_str(bpe.book_series);
+      add_str(bpe.book_genre);
+      add_str(bpe.book_date);
+      uint64_t sz = i < meta.size() ? meta[i].size : 0;
+      uint64_t id = i < meta.size() ? meta[i].lib_id : 0;
+      put64(ent.records, sz);
+      put64(ent.records, id);
+      addChecksum(ent.sum, sz, sizeof(sz));
+      addChecksum(ent.sum, id, sizeof(id));
+    }
+
+#ifndef USE_OPENMP
+  std::lock_guard<std::mutex> lglock(added_mtx);
+#endif
+#ifdef USE_OPENMP
+  omp_set_lock(&added_mtx);
+#endif
+  added[inp_name] = std::move(ent);
+#ifdef USE_OPENMP
+  omp_unset_lock(&added_mtx);
+#endif
+}
+
+bool
+InpxCache::save()
+{
+  if(cache_path.empty() || added.empty())
+    {
+      return true;
+    }
+  std::error_code ec;
+  std::filesystem::create_directories(cache_dir, ec);
+  if(ec)
+    {
+      std::cout << "InpxCache::save error: " << ec.message() << std::endl;
+      return false;
+    }
+
+  // Records of .inp files, which are already in cache file, are kept.
+  std::vector<std::string> names;
+  names.reserve(inp_num + added.size());
+  std::unordered_map<std::string, std::tuple<uint64_t, uint64_t, uint64_t>>
+      old;
+  std::string_view name;
+  uint64_t first;
+  uint64_t num;
+  uint64_t sum;
+  for(size_t i = 0; i < inp_num && inpEntry(i, name, first, num, sum); i++)
+    {
+      std::string key(name);
+      if(added.find(key) == added.end())
+        {
+          old.emplace(key, std::make_tuple(first, num, sum));
+          names.emplace_back(std::move(key));
+        }
+    }
+  for(auto it = added.begin(); it != added.end(); it++)
+    {
+      names.push_back(it->first);
+    }
+  std::sort(names.begin(), names.end());
+
+  std::string table;
+  std::string records;
+  std::string strings;
+  std::unordered_map<std::string_view, uint64_t> string_offsets;
+  std::string_view old_records;
+  std::string_view old_strings;
+  if(!data.empty())
+    {
+      old_records = data.substr(records_pos, strings_pos - records_pos);
+      old_strings = data.substr(strings_pos);
+    }
+
+  auto add_str = [&records, &strings,
+                  &string_offsets](const std::string_view &str) {
+    auto res = string_offsets.emplace(str, strings.size());
+    if(res.second)
+      {
+        strings.append(str);
+      }
+    put64(records, res.first->second);
+    put32(records, static_cast<uint32_t>(str.size()));
+  };
+
+  uint64_t records_count = 0;
+  for(auto it = names.begin(); it != names.end(); it++)
+    {
+      // Name offset is written to table, not to records.
+      std::string_view nm = *it;
+      auto res = string_offsets.emplace(nm, strings.size());
+      if(res.second)
+        {
+          strings.append(nm);
+        }
+      put64(table, res.first->second);
+      put64(table, static_cast<uint64_t>(nm.size()));
+      put64(table, records_count);
+
+      // Records of added and old .inp files are copied the same way, their
+      // checksums are kept as they are.
+      std::string_view recs;
+      std::string_view strs;
+      auto it_a = added.find(*it);
+      if(it_a != added.end())
+        {
+          recs = it_a->second.records;
+          strs = it_a->second.strings;
+          first = 0;
+          num = it_a->second.num;
+          sum = it_a->second.sum;
+        }
+      else
+        {
+          auto &rng = old.at(*it);
+          recs = old_records;
+          strs = old_strings;
+          first = std::get<0>(rng);
+          num = std::get<1>(rng);
+          sum = std::get<2>(rng);
+        }
+      put64(table, num);
+      put64(table, sum);
+      for(uint64_t i = first; i < first + num; i++)
+        {
+          size_t pos = static_cast<size_t>(i) * 88;
+          for(size_t j = 0; j < 6; j++)
+            {
+              uint64_t off = get64(recs, pos + j * 12);
+              uint32_t sz = get32(recs, pos + j * 12 + sizeof(uint64_t));
+              add_str(strs.substr(off, sz));
+            }
+          put64(records, get64(recs, pos + 72));
+          put64(records, get64(recs, pos + 80));
+        }
+      records_count += num;
+    }
+
+  std::string header = "MLIC";
+  header.push_back(3);
+  put64(header, static_cast<uint64_t>(names.size()));
+  put64(header, records_count);
+  put64(header, static_cast<uint64_t>(strings.size()));
+
+  // Several imports of the same .inpx file can save cache at the same time,
+  // so every one writes its own temporary file.
+  static std::atomic<uint64_t> tmp_count(0);
+  std::filesystem::path tmp = cache_path;
+  tmp += std::filesystem::u8path(
+      "." + std::to_string(processId()) + "."
+      + std::to_string(tmp_count.fetch_add(1)) + ".new");
+  std::fstream f;
+  f.open(tmp, std::ios_base::out | std::ios_base::binary);
+  if(!f.is_open())
+    {
+      std::cout << "InpxCache::save error: cannot open " << tmp << std::endl;
+      return false;
+    }
+  f.write(header.c_str(), header.size());
+  f.write(table.c_str(), table.size());
+  f.write(records.c_str(), records.size());
+  f.write(strings.c_str(), strings.size());
+  f.close();
+
+  // Mapping of old file is released before it is replaced.
+  string_offsets.clear();
+  data = std::string_view();
+  mapped.reset();
+  inp_num = 0;
+  records_num = 0;
+
+  std::filesystem::rename(tmp, cache_path, ec);
+  if(ec)
+    {
+      std::cout << "InpxCache::save error: " << ec.message() << std::endl;
+      std::filesystem::remove(tmp, ec);
+      return false;
+    }
+  added.clear();
+
+  removeOld();
+  return true;
+}
+
+bool
+InpxCache::inpEntry(const size_t &n, std::string_view &name, uint64_t &first,
+                    uint64_t &num, uint64_t &sum) const
+{
+  size_t pos = records_pos - static_cast<size_t>(inp_num) * 40 + n * 40;
+  uint64_t off = get64(data, pos);
+  uint64_t sz = get64(data, pos + sizeof(uint64_t));
+  first = get64(data, pos + 2 * sizeof(uint64_t));
+  num = get64(data, pos + 3 * sizeof(uint64_t));
+  sum = get64(data, pos + 4 * sizeof(uint64_t));
+  uint64_t strings_sz = data.size() - strings_pos;
+  if(off > strings_sz || sz > strings_sz - off || first > records_num
+     || num > records_num - first)
+    {
+      return false;
+    }
+  name = data.substr(strings_pos + off, sz);
+  return true;
+}
+
+void
+InpxCache::addChecksum(uint64_t &sum, const std::string_view &str) const
+{
+  for(auto it = str.begin(); it != str.end(); it++)
+    {
+      sum ^= static_cast<unsigned char>(*it);
+      sum *= 1099511628211ULL;
+    }
+}
+
+void
+InpxCache::addChecksum(uint64_t &sum, const uint64_t &val,
+                       const size_t &size) const
+{
+  // Bytes are taken in little-endian order on every platform.
+  for(size_t i = 0; i < size; i++)
+    {
+      sum ^= (val >> (i * 8)) & 0xFF;
+      sum *= 1099511628211ULL;
+    }
+}
+
+uint64_t
+InpxCache::get64(const std::string_view &buf, const size_t &pos)
+{
+  uint64_t val64;
+  std::memcpy(&val64, &buf[pos], sizeof(val64));
+  ByteOrder bo;
+  bo.set_little(val64);
+  val64 = bo;
+  return val64;
+}
+
+uint32_t
+InpxCache::get32(const std::string_view &buf, const size_t &pos)
+{
+  uint32_t val32;
+  std::memcpy(&val32, &buf[pos], sizeof(val32));
+  ByteOrder bo;
+  bo.set_little(val32);
+  val32 = bo;
+  return val32;
+}
+
+void
+InpxCache::put64(std::string &buf, uint64_t val)
+{
+  ByteOrder bo;
+  bo = val;
+  bo.get_little(val);
+  buf.append(reinterpret_cast<char *>(&val), sizeof(val));
+}
+
+void
+InpxCache::put32(std::string &buf, uint32_t val)
+{
+  ByteOrder bo;
+  bo = val;
+  bo.get_little(val);
+  buf.append(reinterpret_cast<char *>(&val), sizeof(val));
+}
+
+uint64_t
+InpxCache::processId()
+{
+#ifdef _WIN32
+  return static_cast<uint64_t>(_getpid());
+#endif
+#ifndef _WIN32
+  return static_cast<uint64_t>(getpid());
+#endif
+}
+
+void
+InpxCache::removeOld()
+{
+  std::vector<std::pair<std::filesystem::file_time_type,
+                        std::filesystem::path>>
+      files;
+  std::error_code ec;
+  for(auto &pp : std::filesystem::directory_iterator(cache_dir, ec))
+    {
+      if(pp.path().extension().u8string() == ".inpxc")
+        {
+          std::error_code ec_t;
+          files.emplace_back(pp.last_write_time(ec_t), pp.path());
+        }
+    }
+  if(files.size() <= max_files)
+    {
+      return void();
+    }
+  std::sort(files.begin(), files.end(),
+            [](const auto &el1, const auto &el2) {
+              return el1.first > el2.first;
+            });
+  for(size_t i = max_files; i < files.size(); i++)
+    {
+      std::filesystem::remove(files[i].second, ec);
+    }
+}
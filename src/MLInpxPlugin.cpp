@@ -14,6 +14,8 @@
  * this program. If not, see <https://www.gnu.org/licenses/>.
  */
 #include <CollectionProcessGui.h>
+#include <CollectionWatchGui.h>
+#include <ImportQueueGui.h>
 #include <MLInpxPlugin.h>
 #include <giomm-2.68/giomm/liststore.h>
 #include <gtkmm-4.0/gdkmm/monitor.h>
@@ -119,23 +121,60 @@ MLInpxPlugin::createWindow(Gtk::Window *parent_window)
         std::bind(&MLInpxPlugin::fileDialog, this, 2));
     grid->attach(*open, 1, 3, 1, 1);
 
+    Gtk::Box *sources_box
+        = Gtk::make_managed<Gtk::Box>(Gtk::Orientation::HORIZONTAL);
+    grid->attach(*sources_box, 0, 4, 2, 1);
+
+    sources_lab = Gtk::make_managed<Gtk::Label>();
+    sources_lab->set_margin(5);
+    sources_lab->set_halign(Gtk::Align::START);
+    sources_lab->set_hexpand(true);
+    sources_lab->set_name("windowLabel");
+    sources_lab->set_wrap(true);
+    sources_lab->set_wrap_mode(Pango::WrapMode::WORD_CHAR);
+    sources_box->append(*sources_lab);
+    updateSources();
+
+    Gtk::Button *add_source = Gtk::make_managed<Gtk::Button>();
+    add_source->set_margin(5);
+    add_source->set_halign(Gtk::Align::CENTER);
+    add_source->set_name("operationBut");
+    add_source->set_label(gettext("Add source"));
+    add_source->set_tooltip_text(
+        gettext("Add .inpx file and books directory to merge them with "
+                "current ones into one collection"));
+    add_source->signal_clicked().connect(
+        std::bind(&MLInpxPlugin::addSource, this));
+    sources_box->append(*add_source);
+
+    Gtk::Button *clear_sources = Gtk::make_managed<Gtk::Button>();
+    clear_sources->set_margin(5);
+    clear_sources->set_halign(Gtk::Align::CENTER);
+    clear_sources->set_name("cancelBut");
+    clear_sources->set_label(gettext("Clear"));
+    clear_sources->signal_clicked().connect([this] {
+      extra_sources.clear();
+      updateSources();
+    });
+    sources_box->append(*clear_sources);
+
     lab = Gtk::make_managed<Gtk::Label>();
     lab->set_margin(5);
     lab->set_halign(Gtk::Align::START);
     lab->set_name("windowLabel");
     lab->set_text(gettext("New collection name:"));
-    grid->attach(*lab, 0, 4, 2, 1);
+    grid->attach(*lab, 0, 5, 2, 1);
 
     collection_name = Gtk::make_managed<Gtk::Entry>();
     collection_name->set_margin(5);
     collection_name->set_halign(Gtk::Align::FILL);
     collection_name->set_hexpand(true);
     collection_name->set_name("windowEntry");
-    grid->attach(*collection_name, 0, 5, 2, 1);
+    grid->attach(*collection_name, 0, 6, 2, 1);
 
     Gtk::Box *thr_box
         = Gtk::make_managed<Gtk::Box>(Gtk::Orientation::HORIZONTAL);
-    grid->attach(*thr_box, 0, 6, 2, 1);
+    grid->attach(*thr_box, 0, 7, 2, 1);
 
     lab = Gtk::make_managed<Gtk::Label>();
     lab->set_margin(5);
@@ -163,11 +202,198 @@ MLInpxPlugin::createWindow(Gtk::Window *parent_window)
     thr_num->set_text("1");
     thr_box->append(*thr_num);
 
+    Gtk::Box *rate_box
+        = Gtk::make_managed<Gtk::Box>(Gtk::Orientation::HORIZONTAL);
+    grid->attach(*rate_box, 0, 8, 2, 1);
+
+    lab = Gtk::make_managed<Gtk::Label>();
+    lab->set_margin(5);
+    lab->set_halign(Gtk::Align::START);
+    lab->set_name("windowLabel");
+    lab->set_text(gettext("Verification speed limit, MiB/s (0 - no limit):"));
+    rate_box->append(*lab);
+
+    rate_limit = Gtk::make_managed<Gtk::Entry>();
+    rate_limit->set_margin(5);
+    rate_limit->set_halign(Gtk::Align::START);
+    rate_limit->set_max_width_chars(5);
+    rate_limit->set_name("windowEntry");
+    rate_limit->set_alignment(Gtk::Align::CENTER);
+    rate_limit->set_text("0");
+    rate_box->append(*rate_limit);
+
+    Gtk::Box *prio_box
+        = Gtk::make_managed<Gtk::Box>(Gtk::Orientation::HORIZONTAL);
+    grid->attach(*prio_box, 0, 9, 2, 1);
+
+    lab = Gtk::make_managed<Gtk::Label>();
+    lab->set_margin(5);
+    lab->set_halign(Gtk::Align::START);
+    lab->set_name("windowLabel");
+    lab->set_text(gettext("Priority:"));
+    prio_box->append(*lab);
+
+    std::vector<Glib::ustring> priorities
+        = { gettext("normal"), gettext("low"), gettext("idle") };
+    priority = Gtk::make_managed<Gtk::DropDown>(priorities);
+    priority->set_margin(5);
+    priority->set_halign(Gtk::Align::START);
+    priority->set_name("comboBox");
+    priority->set_selected(0);
+    prio_box->append(*priority);
+
+    lab = Gtk::make_managed<Gtk::Label>();
+    lab->set_margin(5);
+    lab->set_halign(Gtk::Align::START);
+    lab->set_name("windowLabel");
+    lab->set_text(gettext("CPUs (for example 0-3,6, empty - all):"));
+    prio_box->append(*lab);
+
+    cpus = Gtk::make_managed<Gtk::Entry>();
+    cpus->set_margin(5);
+    cpus->set_halign(Gtk::Align::START);
+    cpus->set_max_width_chars(10);
+    cpus->set_name("windowEntry");
+    prio_box->append(*cpus);
+
+    keep_newest = Gtk::make_managed<Gtk::CheckButton>();
+    keep_newest->set_margin(5);
+    keep_newest->set_halign(Gtk::Align::START);
+    keep_newest->set_label(
+        gettext("Keep only newest copy of duplicate books"));
+    keep_newest->set_tooltip_text(
+        gettext("Books with equal LIBID or equal author, title and size are "
+                "listed in duplicates.txt in collection directory anyway"));
+    grid->attach(*keep_newest, 0, 10, 2, 1);
+
+    extract_cache = Gtk::make_managed<Gtk::CheckButton>();
+    extract_cache->set_margin(5);
+    extract_cache->set_halign(Gtk::Align::START);
+    extract_cache->set_label(gettext("Extract annotations and covers"));
+    extract_cache->set_tooltip_text(
+        gettext("Annotations and cover thumbnails of fb2 books are saved to "
+                "cache in collection directory during import"));
+    grid->attach(*extract_cache, 0, 11, 2, 1);
+
+    import_orphans = Gtk::make_managed<Gtk::CheckButton>();
+    import_orphans->set_margin(5);
+    import_orphans->set_halign(Gtk::Align::START);
+    import_orphans->set_label(gettext("Import archives without .inp files"));
+    import_orphans->set_tooltip_text(
+        gettext("Records for books from archives, which are absent in .inpx "
+                "file, are made from fb2 headers"));
+    grid->attach(*import_orphans, 0, 12, 2, 1);
+
+#ifdef USE_SQLITE
+    export_sqlite = Gtk::make_managed<Gtk::CheckButton>();
+    export_sqlite->set_margin(5);
+    export_sqlite->set_halign(Gtk::Align::START);
+    export_sqlite->set_label(gettext("Export catalog to SQLite database"));
+    export_sqlite->set_tooltip_text(
+        gettext("Base is also written to catalog.sqlite file in collection "
+                "directory"));
+    grid->attach(*export_sqlite, 0, 13, 2, 1);
+#endif
+
+    Gtk::Box *reader_box
+        = Gtk::make_managed<Gtk::Box>(Gtk::Orientation::HORIZONTAL);
+    grid->attach(*reader_box, 0, 14, 2, 1);
+
+    lab = Gtk::make_managed<Gtk::Label>();
+    lab->set_margin(5);
+    lab->set_halign(Gtk::Align::START);
+    lab->set_name("windowLabel");
+    lab->set_text(gettext("Archives reading:"));
+    reader_box->append(*lab);
+
+    std::vector<Glib::ustring> readers
+        = { gettext("standard"), "pread", "io_uring" };
+    reader = Gtk::make_managed<Gtk::DropDown>(readers);
+    reader->set_margin(5);
+    reader->set_halign(Gtk::Align::START);
+    reader->set_name("comboBox");
+    reader->set_selected(0);
+    reader->set_tooltip_text(
+        gettext("io_uring keeps several reads in flight, it is useful for "
+                "SSD and RAID arrays"));
+    reader_box->append(*reader);
+
+    lab = Gtk::make_managed<Gtk::Label>();
+    lab->set_margin(5);
+    lab->set_halign(Gtk::Align::START);
+    lab->set_name("windowLabel");
+    lab->set_text(gettext("Queue depth:"));
+    reader_box->append(*lab);
+
+    queue_depth = Gtk::make_managed<Gtk::Entry>();
+    queue_depth->set_margin(5);
+    queue_depth->set_halign(Gtk::Align::START);
+    queue_depth->set_max_width_chars(5);
+    queue_depth->set_name("windowEntry");
+    queue_depth->set_alignment(Gtk::Align::CENTER);
+    queue_depth->set_text("16");
+    reader_box->append(*queue_depth);
+
+    lab = Gtk::make_managed<Gtk::Label>();
+    lab->set_margin(5);
+    lab->set_halign(Gtk::Align::START);
+    lab->set_name("windowLabel");
+    lab->set_text(gettext("Threads per disk:"));
+    reader_box->append(*lab);
+
+    device_threads = Gtk::make_managed<Gtk::Entry>();
+    device_threads->set_margin(5);
+    device_threads->set_halign(Gtk::Align::START);
+    device_threads->set_max_width_chars(5);
+    device_threads->set_name("windowEntry");
+    device_threads->set_alignment(Gtk::Align::CENTER);
+    device_threads->set_text("0");
+    device_threads->set_tooltip_text(
+        gettext("Archives located on several disks are processed on all "
+                "disks at the same time. Number of archives processed on one "
+                "disk simultaneously can be limited (0 - no limit)"));
+    reader_box->append(*device_threads);
+
+    write_trace = Gtk::make_managed<Gtk::CheckButton>();
+    write_trace->set_margin(5);
+    write_trace->set_halign(Gtk::Align::START);
+    write_trace->set_label(gettext("Write import timeline"));
+    write_trace->set_tooltip_text(
+        gettext("Timeline of import threads is saved to trace.json file in "
+                "collection directory. It can be opened in Perfetto or "
+                "chrome://tracing"));
+    grid->attach(*write_trace, 0, 15, 2, 1);
+
+    Gtk::Box *keys_box
+        = Gtk::make_managed<Gtk::Box>(Gtk::Orientation::HORIZONTAL);
+    grid->attach(*keys_box, 0, 16, 2, 1);
+
+    lab = Gtk::make_managed<Gtk::Label>();
+    lab->set_margin(5);
+    lab->set_halign(Gtk::Align::START);
+    lab->set_name("windowLabel");
+    lab->set_text(gettext("Search keys:"));
+    keys_box->append(*lab);
+
+    std::vector<Glib::ustring> keys_modes
+        = { gettext("none"), gettext("case folded"),
+            gettext("transliterated to Latin") };
+    search_keys = Gtk::make_managed<Gtk::DropDown>(keys_modes);
+    search_keys->set_margin(5);
+    search_keys->set_halign(Gtk::Align::START);
+    search_keys->set_name("comboBox");
+    search_keys->set_selected(0);
+    search_keys->set_tooltip_text(
+        gettext("Normalized authors, titles and series are saved to "
+                "search_keys file in collection directory, so search does "
+                "not need to normalize them"));
+    keys_box->append(*search_keys);
+
     Gtk::Grid *controls_grid = Gtk::make_managed<Gtk::Grid>();
     controls_grid->set_halign(Gtk::Align::FILL);
     controls_grid->set_hexpand(true);
     controls_grid->set_column_homogeneous(true);
-    grid->attach(*controls_grid, 0, 7, 2, 1);
+    grid->attach(*controls_grid, 0, 17, 2, 1);
 
     Gtk::Button *import = Gtk::make_managed<Gtk::Button>();
     import->set_margin(5);
@@ -175,9 +401,49 @@ MLInpxPlugin::createWindow(Gtk::Window *parent_window)
     import->set_name("applyBut");
     import->set_label(gettext("Import"));
     import->signal_clicked().connect(
-        std::bind(&MLInpxPlugin::checkEntries, this));
+        std::bind(&MLInpxPlugin::checkEntries, this, false));
     controls_grid->attach(*import, 0, 0, 1, 1);
 
+    Gtk::Button *add_queue = Gtk::make_managed<Gtk::Button>();
+    add_queue->set_margin(5);
+    add_queue->set_halign(Gtk::Align::CENTER);
+    add_queue->set_name("operationBut");
+    add_queue->set_label(gettext("Add to queue"));
+    add_queue->signal_clicked().connect(
+        std::bind(&MLInpxPlugin::checkEntries, this, true));
+    controls_grid->attach(*add_queue, 1, 0, 1, 1);
+
+    Gtk::Button *plan = Gtk::make_managed<Gtk::Button>();
+    plan->set_margin(5);
+    plan->set_halign(Gtk::Align::CENTER);
+    plan->set_name("operationBut");
+    plan->set_label(gettext("Plan"));
+    plan->signal_clicked().connect(std::bind(&MLInpxPlugin::planImport, this));
+    controls_grid->attach(*plan, 2, 0, 1, 1);
+
+    Gtk::Button *watch = Gtk::make_managed<Gtk::Button>();
+    watch->set_margin(5);
+    watch->set_halign(Gtk::Align::CENTER);
+    watch->set_name("operationBut");
+    watch->set_label(gettext("Watch"));
+    watch->set_tooltip_text(
+        gettext("Watch .inpx file and books directory and update existing "
+                "collection when they are changed"));
+    watch->signal_clicked().connect(
+        std::bind(&MLInpxPlugin::watchCollection, this));
+    controls_grid->attach(*watch, 3, 0, 1, 1);
+
+    Gtk::Button *verify = Gtk::make_managed<Gtk::Button>();
+    verify->set_margin(5);
+    verify->set_halign(Gtk::Align::CENTER);
+    verify->set_name("operationBut");
+    verify->set_label(gettext("Verify"));
+    verify->set_tooltip_text(gettext(
+        "Check that archives of existing collection match its base"));
+    verify->signal_clicked().connect(
+        std::bind(&MLInpxPlugin::verifyCollection, this));
+    controls_grid->attach(*verify, 4, 0, 1, 1);
+
     Gtk::Button *cancel = Gtk::make_managed<Gtk::Button>();
     cancel->set_margin(5);
     cancel->set_halign(Gtk::Align::CENTER);
@@ -185,7 +451,7 @@ MLInpxPlugin::createWindow(Gtk::Window *parent_window)
     cancel->set_label(gettext("Close"));
     cancel->signal_clicked().connect(
         std::bind(&Gtk::Window::close, main_window));
-    controls_grid->attach(*cancel, 1, 0, 1, 1);
+    controls_grid->attach(*cancel, 5, 0, 1, 1);
 
     main_window->signal_close_request().connect(
         [this] {
@@ -394,7 +660,7 @@ MLInpxPlugin::booksDirectoryPathSlot(
 #endif
 
 void
-MLInpxPlugin::checkEntries()
+MLInpxPlugin::checkEntries(const bool &queue)
 {
   std::filesystem::path inpx_path
       = std::filesystem::u8path(path_to_inpx->get_text().c_str());
@@ -422,15 +688,320 @@ MLInpxPlugin::checkEntries()
                          coll_path.filename().u8string(), 3);
       return void();
     }
-  if(std::filesystem::exists(coll_path))
+  // Interrupted import of collection can be started again.
+  if(std::filesystem::exists(coll_path)
+     && !std::filesystem::exists(
+         coll_path / std::filesystem::u8path("import_incomplete")))
     {
       confirmationDialog(inpx_path, books_path,
                          coll_path.filename().u8string(), 4);
       return void();
     }
 
-  confirmationDialog(inpx_path, books_path, coll_path.filename().u8string(),
-                     5);
+  if(queue)
+    {
+      addToQueue(importSources(inpx_path, books_path),
+                 coll_path.filename().u8string(), importOptions());
+    }
+  else
+    {
+      confirmationDialog(inpx_path, books_path,
+                         coll_path.filename().u8string(), 5);
+    }
+}
+
+void
+MLInpxPlugin::addToQueue(const std::vector<ImportSource> &sources,
+                         const std::string &coll_name,
+                         const ImportOptions &options)
+{
+  if(!import_queue)
+    {
+      import_queue = new ImportQueueGui(main_window, af, threadsNumber());
+      import_queue->signal_closed = [this] {
+        import_queue = nullptr;
+      };
+      import_queue->createWindow();
+    }
+  if(!import_queue->addJob(sources, coll_name, options))
+    {
+      confirmationDialog(sources.back().inpx_path, sources.back().books_path,
+                         coll_name, 6);
+    }
+}
+
+void
+MLInpxPlugin::planImport()
+{
+  std::filesystem::path inpx_path
+      = std::filesystem::u8path(path_to_inpx->get_text().c_str());
+  std::filesystem::path books_path
+      = std::filesystem::u8path(path_to_books->get_text().c_str());
+  if(!std::filesystem::exists(inpx_path))
+    {
+      confirmationDialog(inpx_path, books_path, std::string(), 1);
+      return void();
+    }
+  if(!std::filesystem::exists(books_path))
+    {
+      confirmationDialog(inpx_path, books_path, std::string(), 2);
+      return void();
+    }
+
+  CollectionProcessGui *cpg
+      = new CollectionProcessGui(main_window, af, threadsNumber());
+  cpg->setOptions(importOptions());
+  cpg->createPlanWindow(importSources(inpx_path, books_path));
+}
+
+void
+MLInpxPlugin::watchCollection()
+{
+  std::filesystem::path inpx_path
+      = std::filesystem::u8path(path_to_inpx->get_text().c_str());
+  std::filesystem::path books_path
+      = std::filesystem::u8path(path_to_books->get_text().c_str());
+  std::filesystem::path coll_path = af->homePath();
+  coll_path /= std::filesystem::u8path(".local/share/MyLibrary/Collections");
+  std::string coll_nm = collection_name->get_text();
+  coll_path /= std::filesystem::u8path(coll_nm);
+  if(!std::filesystem::exists(inpx_path))
+    {
+      confirmationDialog(inpx_path, books_path,
+                         coll_path.filename().u8string(), 1);
+      return void();
+    }
+  if(!std::filesystem::exists(books_path))
+    {
+      confirmationDialog(inpx_path, books_path,
+                         coll_path.filename().u8string(), 2);
+      return void();
+    }
+  if(coll_nm.empty())
+    {
+      confirmationDialog(inpx_path, books_path,
+                         coll_path.filename().u8string(), 3);
+      return void();
+    }
+  if(!std::filesystem::exists(coll_path))
+    {
+      confirmationDialog(inpx_path, books_path,
+                         coll_path.filename().u8string(), 7);
+      return void();
+    }
+
+  CollectionWatchGui *cwg
+      = new CollectionWatchGui(main_window, af, threadsNumber());
+  cwg->createWindow(importSources(inpx_path, books_path),
+                    coll_path.filename().u8string(), importOptions());
+}
+
+void
+MLInpxPlugin::verifyCollection()
+{
+  std::filesystem::path coll_path = af->homePath();
+  coll_path /= std::filesystem::u8path(".local/share/MyLibrary/Collections");
+  std::string coll_nm = collection_name->get_text();
+  coll_path /= std::filesystem::u8path(coll_nm);
+  if(coll_nm.empty())
+    {
+      confirmationDialog(std::filesystem::path(), std::filesystem::path(),
+                         coll_nm, 3);
+      return void();
+    }
+  if(!std::filesystem::exists(coll_path))
+    {
+      confirmationDialog(std::filesystem::path(), std::filesystem::path(),
+                         coll_nm, 7);
+      return void();
+    }
+
+  std::stringstream strm;
+  strm.imbue(std::locale("C"));
+  strm.str(rate_limit->get_text());
+  double limit = 0.0;
+  strm >> limit;
+  if(!strm || limit < 0.0)
+    {
+      limit = 0.0;
+    }
+
+  CollectionProcessGui *cpg
+      = new CollectionProcessGui(main_window, af, threadsNumber());
+  cpg->setOptions(importOptions());
+  cpg->createVerifyWindow(coll_path.filename().u8string(),
+                          limit * 1048576.0);
+}
+
+void
+MLInpxPlugin::addSource()
+{
+  std::filesystem::path inpx_path
+      = std::filesystem::u8path(path_to_inpx->get_text().c_str());
+  std::filesystem::path books_path
+      = std::filesystem::u8path(path_to_books->get_text().c_str());
+  if(!std::filesystem::exists(inpx_path))
+    {
+      confirmationDialog(inpx_path, books_path, std::string(), 1);
+      return void();
+    }
+  if(!std::filesystem::exists(books_path))
+    {
+      confirmationDialog(inpx_path, books_path, std::string(), 2);
+      return void();
+    }
+  for(auto it = extra_sources.begin(); it != extra_sources.end(); it++)
+    {
+      if(it->inpx_path == inpx_path && it->books_path == books_path)
+        {
+          return void();
+        }
+    }
+  extra_sources.emplace_back(inpx_path, books_path);
+  updateSources();
+}
+
+void
+MLInpxPlugin::updateSources()
+{
+  Glib::ustring txt(gettext("Additional sources:"));
+  if(extra_sources.empty())
+    {
+      txt += " ";
+      txt += gettext("none");
+    }
+  for(auto it = extra_sources.begin(); it != extra_sources.end(); it++)
+    {
+      txt += "\n";
+      txt += Glib::ustring(it->inpx_path.u8string()) + " - "
+             + Glib::ustring(it->books_path.u8string());
+    }
+  sources_lab->set_text(txt);
+}
+
+std::vector<ImportSource>
+MLInpxPlugin::importSources(const std::filesystem::path &inpx_path,
+                            const std::filesystem::path &books_path)
+{
+  std::vector<ImportSource> result;
+  result.reserve(extra_sources.size() + 1);
+  result.emplace_back(inpx_path, books_path);
+  for(auto it = extra_sources.begin(); it != extra_sources.end(); it++)
+    {
+      if(it->inpx_path != inpx_path || it->books_path != books_path)
+        {
+          result.push_back(*it);
+        }
+    }
+  return result;
+}
+
+ImportOptions
+MLInpxPlugin::importOptions()
+{
+  ImportOptions options;
+  options.keep_newest_duplicate = keep_newest->get_active();
+  options.extract_cache = extract_cache->get_active();
+  options.import_orphans = import_orphans->get_active();
+#ifdef USE_SQLITE
+  options.export_sqlite = export_sqlite->get_active();
+#endif
+  options.write_trace = write_trace->get_active();
+  options.priority = static_cast<int>(priority->get_selected());
+  if(options.priority > ImportOptions::Idle)
+    {
+      options.priority = ImportOptions::Normal;
+    }
+
+  options.search_keys = static_cast<int>(search_keys->get_selected());
+  if(options.search_keys > ImportOptions::LatinKeys)
+    {
+      options.search_keys = ImportOptions::NoKeys;
+    }
+
+  options.reader = static_cast<int>(reader->get_selected());
+  if(options.reader > ImportOptions::IoUring)
+    {
+      options.reader = ImportOptions::Standard;
+    }
+  std::stringstream qd_strm;
+  qd_strm.imbue(std::locale("C"));
+  qd_strm.str(queue_depth->get_text());
+  if(!(qd_strm >> options.queue_depth) || options.queue_depth < 1)
+    {
+      options.queue_depth = 16;
+    }
+
+  std::stringstream dt_strm;
+  dt_strm.imbue(std::locale("C"));
+  dt_strm.str(device_threads->get_text());
+  if(!(dt_strm >> options.device_threads) || options.device_threads < 0)
+    {
+      options.device_threads = 0;
+    }
+
+  // CPU list is given as comma separated numbers and ranges: 0-3,6
+  std::string str = cpus->get_text();
+  std::string::size_type n = 0;
+  while(n < str.size())
+    {
+      std::string::size_type n_end = str.find(",", n);
+      if(n_end == std::string::npos)
+        {
+          n_end = str.size();
+        }
+      std::string range = str.substr(n, n_end - n);
+      n = n_end + 1;
+
+      std::stringstream strm;
+      strm.imbue(std::locale("C"));
+      std::string::size_type dash = range.find("-");
+      int first = -1;
+      int last = -1;
+      strm.str(range.substr(0, dash));
+      if(!(strm >> first))
+        {
+          continue;
+        }
+      if(dash == std::string::npos)
+        {
+          last = first;
+        }
+      else
+        {
+          strm.clear();
+          strm.str(range.substr(dash + 1));
+          if(!(strm >> last))
+            {
+              continue;
+            }
+        }
+      for(int i = first; i >= 0 && i <= last; i++)
+        {
+          options.cpus.push_back(i);
+        }
+    }
+  return options;
+}
+
+int
+MLInpxPlugin::threadsNumber()
+{
+  std::stringstream strm;
+  strm.imbue(std::locale("C"));
+  std::string str = thr_num->get_text();
+  if(str.empty())
+    {
+      str = "1";
+    }
+  strm.str(str);
+  int num;
+  strm >> num;
+  if(num <= 0)
+    {
+      num = 1;
+    }
+  return num;
 }
 
 void
@@ -474,6 +1045,18 @@ MLInpxPlugin::confirmationDialog(const std::filesystem::path &inpx_path,
         lab_txt = gettext("Are you sure?");
         break;
       }
+    case 6:
+      {
+        window_title = gettext("Error!");
+        lab_txt = gettext("Collection is already in import queue!");
+        break;
+      }
+    case 7:
+      {
+        window_title = gettext("Error!");
+        lab_txt = gettext("Collection does not exist!");
+        break;
+      }
     default:
       return void();
     }
@@ -507,23 +1090,11 @@ MLInpxPlugin::confirmationDialog(const std::filesystem::path &inpx_path,
       yes->set_label(gettext("Yes"));
       yes->signal_clicked().connect(
           [this, inpx_path, books_path, coll_name, window] {
-            std::stringstream strm;
-            strm.imbue(std::locale("C"));
-            std::string str = thr_num->get_text();
-            if(str.empty())
-              {
-                str = "1";
-              }
-            strm.str(str);
-            int num;
-            strm >> num;
-            if(num <= 0)
-              {
-                num = 1;
-              }
             CollectionProcessGui *cpg
-                = new CollectionProcessGui(main_window, af, num);
-            cpg->createWindow(inpx_path, books_path, coll_name);
+                = new CollectionProcessGui(main_window, af, threadsNumber());
+            cpg->setOptions(importOptions());
+            cpg->createWindow(importSources(inpx_path, books_path),
+                              coll_name);
             window->close();
           });
       grid->attach(*yes, 0, 1, 1, 1);
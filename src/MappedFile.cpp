@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <MappedFile.h>
+#include <iostream>
+
+#ifdef __linux
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+{
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef __linux
+  if(addr)
+    {
+      munmap(const_cast<char *>(addr), size);
+    }
+#endif
+#ifdef _WIN32
+  if(addr)
+    {
+      UnmapViewOfFile(addr);
+    }
+  if(mapping)
+    {
+      CloseHandle(mapping);
+    }
+  if(file != INVALID_HANDLE_VALUE)
+    {
+      CloseHandle(file);
+    }
+#endif
+}
+
+bool
+MappedFile::open(const std::filesystem::path &file_path)
+{
+  if(addr)
+    {
+      return false;
+    }
+#ifdef __linux
+  int fd = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+  if(fd < 0)
+    {
+      std::cout << "MappedFile::open error: cannot open " << file_path
+                << std::endl;
+      return false;
+    }
+  struct stat st;
+  if(fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+      ::close(fd);
+      return false;
+    }
+  void *res = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ,
+                   MAP_PRIVATE, fd, 0);
+  // Mapping stays valid after descriptor is closed.
+  ::close(fd);
+  if(res == MAP_FAILED)
+    {
+      std::cout << "MappedFile::open error: cannot map " << file_path
+                << std::endl;
+      return false;
+    }
+  madvise(res, static_cast<size_t>(st.st_size), MADV_WILLNEED);
+  addr = static_cast<const char *>(res);
+  size = static_cast<size_t>(st.st_size);
+  return true;
+#endif
+#ifdef _WIN32
+  file = CreateFileW(file_path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                     nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if(file == INVALID_HANDLE_VALUE)
+    {
+      std::cout << "MappedFile::open error: cannot open " << file_path
+                << std::endl;
+      return false;
+    }
+  LARGE_INTEGER fsz;
+  if(!GetFileSizeEx(file, &fsz) || fsz.QuadPart == 0)
+    {
+      return false;
+    }
+  mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if(!mapping)
+    {
+      std::cout << "MappedFile::open error: cannot map " << file_path
+                << std::endl;
+      return false;
+    }
+  addr = static_cast<const char *>(
+      MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+  if(!addr)
+    {
+      std::cout << "MappedFile::open error: cannot map " << file_path
+                << std::endl;
+      return false;
+    }
+  size = static_cast<size_t>(fsz.QuadPart);
+  return true;
+#endif
+#if !defined(__linux) && !defined(_WIN32)
+  return false;
+#endif
+}
+
+std::string_view
+MappedFile::data() const
+{
+  return std::string_view(addr, size);
+}
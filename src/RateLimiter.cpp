@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <RateLimiter.h>
+#include <algorithm>
+#include <thread>
+
+RateLimiter::RateLimiter(const double &bytes_per_sec)
+{
+  this->bytes_per_sec = bytes_per_sec;
+  next_slot = std::chrono::steady_clock::now();
+}
+
+bool
+RateLimiter::acquire(const double &bytes,
+                     const std::function<bool()> &canceled)
+{
+  if(bytes_per_sec <= 0.0)
+    {
+      return true;
+    }
+
+  // Every caller reserves time slot proportional to bytes it is going to
+  // read, so average rate of all callers does not exceed the limit.
+  std::chrono::steady_clock::time_point start;
+  {
+    std::lock_guard<std::mutex> lglock(mtx);
+    std::chrono::steady_clock::time_point now
+        = std::chrono::steady_clock::now();
+    if(next_slot < now)
+      {
+        next_slot = now;
+      }
+    start = next_slot;
+    next_slot += std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::duration<double>(bytes / bytes_per_sec));
+  }
+
+  for(;;)
+    {
+      if(canceled && canceled())
+        {
+          return false;
+        }
+      std::chrono::steady_clock::time_point now
+          = std::chrono::steady_clock::now();
+      if(now >= start)
+        {
+          return true;
+        }
+      std::this_thread::sleep_for(std::min(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(start - now),
+          std::chrono::nanoseconds(100000000)));
+    }
+}
@@ -0,0 +1,445 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <ReadEngine.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifdef __linux
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#if __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup)
+#include <linux/io_uring.h>
+#define HAVE_IO_URING
+#endif
+#endif
+
+ReadEngine::ReadEngine(const int &type, const unsigned &queue_depth)
+{
+  this->queue_depth = queue_depth;
+  if(this->queue_depth < 1)
+    {
+      this->queue_depth = 1;
+    }
+#ifdef __linux
+  if(type == IoUring && setupRing())
+    {
+      this->type = IoUring;
+    }
+#endif
+}
+
+ReadEngine::~ReadEngine()
+{
+#ifdef __linux
+  closeRing();
+#endif
+}
+
+int
+ReadEngine::engineType() const
+{
+  return type;
+}
+
+uint64_t
+ReadEngine::memorySize() const
+{
+#ifdef __linux
+  if(buffers)
+    {
+      return static_cast<uint64_t>(block_size) * queue_depth;
+    }
+#endif
+  return 0;
+}
+
+bool
+ReadEngine::readFile(const std::filesystem::path &file_path,
+                     std::string &result,
+                     const std::function<bool()> &canceled)
+{
+#ifdef __linux
+  if(type == IoUring)
+    {
+      int fd = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+      if(fd < 0)
+        {
+          std::cout << "ReadEngine::readFile error: cannot open "
+                    << file_path << std::endl;
+          return false;
+        }
+      bool res = readRing(fd, result, canceled);
+      ::close(fd);
+      return res;
+    }
+#endif
+  return readPread(file_path, result, canceled);
+}
+
+bool
+ReadEngine::readPread(const std::filesystem::path &file_path,
+                      std::string &result,
+                      const std::function<bool()> &canceled)
+{
+#ifdef __linux
+  int fd = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+  if(fd < 0)
+    {
+      std::cout << "ReadEngine::readPread error: cannot open " << file_path
+                << std::endl;
+      return false;
+    }
+  struct stat st;
+  if(fstat(fd, &st) != 0)
+    {
+      ::close(fd);
+      return false;
+    }
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  result.resize(static_cast<size_t>(st.st_size));
+  size_t off = 0;
+  while(off < result.size())
+    {
+      if(canceled())
+        {
+          ::close(fd);
+          return false;
+        }
+      size_t len = std::min(block_size, result.size() - off);
+      ssize_t rd = pread(fd, &result[off], len, static_cast<off_t>(off));
+      if(rd < 0 && errno == EINTR)
+        {
+          continue;
+        }
+      if(rd <= 0)
+        {
+          std::cout << "ReadEngine::readPread error: cannot read "
+                    << file_path << std::endl;
+          ::close(fd);
+          return false;
+        }
+      off += static_cast<size_t>(rd);
+    }
+  ::close(fd);
+  return true;
+#endif
+#ifndef __linux
+  std::fstream f;
+  f.open(file_path, std::ios_base::in | std::ios_base::binary);
+  if(!f.is_open())
+    {
+      std::cout << "ReadEngine::readPread error: cannot open " << file_path
+                << std::endl;
+      return false;
+    }
+  f.seekg(0, std::ios_base::end);
+  result.resize(static_cast<size_t>(f.tellg()));
+  f.seekg(0, std::ios_base::beg);
+  size_t off = 0;
+  while(off < result.size())
+    {
+      if(canceled())
+        {
+          return false;
+        }
+      size_t len = std::min(block_size, result.size() - off);
+      f.read(&result[off], len);
+      if(!f)
+        {
+          std::cout << "ReadEngine::readPread error: cannot read "
+                    << file_path << std::endl;
+          return false;
+        }
+      off += len;
+    }
+  return true;
+#endif
+}
+
+#ifdef __linux
+bool
+ReadEngine::setupRing()
+{
+#ifdef HAVE_IO_URING
+  struct io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+  int fd = static_cast<int>(
+      syscall(__NR_io_uring_setup, queue_depth, &params));
+  if(fd < 0)
+    {
+      return false;
+    }
+  ring_fd = fd;
+
+  sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_size = params.cq_off.cqes
+            + params.cq_entries * sizeof(struct io_uring_cqe);
+  bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+  if(single)
+    {
+      sq_size = std::max(sq_size, cq_size);
+      cq_size = 0;
+    }
+  sq_ptr = mmap(nullptr, sq_size, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+  if(sq_ptr == MAP_FAILED)
+    {
+      sq_ptr = nullptr;
+      closeRing();
+      return false;
+    }
+  if(single)
+    {
+      cq_ptr = sq_ptr;
+    }
+  else
+    {
+      cq_ptr = mmap(nullptr, cq_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+      if(cq_ptr == MAP_FAILED)
+        {
+          cq_ptr = nullptr;
+          closeRing();
+          return false;
+        }
+    }
+  sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+  sqes = mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE,
+              MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+  if(sqes == MAP_FAILED)
+    {
+      sqes = nullptr;
+      closeRing();
+      return false;
+    }
+
+  char *sq = static_cast<char *>(sq_ptr);
+  char *cq = static_cast<char *>(cq_ptr);
+  sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  sq_mask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  cq_mask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  cqes = cq + params.cq_off.cqes;
+
+  buffers.reset(new char[block_size * queue_depth]);
+  iovs.resize(queue_depth);
+  slot_offset.resize(queue_depth);
+  slot_length.resize(queue_depth);
+  for(unsigned i = 0; i < queue_depth; i++)
+    {
+      iovs[i].iov_base = buffers.get() + block_size * i;
+      iovs[i].iov_len = block_size;
+    }
+  // Buffers can not be registered if RLIMIT_MEMLOCK is too small, plain
+  // vectored reads are used in this case.
+  registered = syscall(__NR_io_uring_register, ring_fd,
+                       IORING_REGISTER_BUFFERS, iovs.data(), queue_depth)
+               == 0;
+  return true;
+#endif
+#ifndef HAVE_IO_URING
+  return false;
+#endif
+}
+
+void
+ReadEngine::closeRing()
+{
+  if(sqes)
+    {
+      munmap(sqes, sqes_size);
+      sqes = nullptr;
+    }
+  if(cq_ptr && cq_ptr != sq_ptr)
+    {
+      munmap(cq_ptr, cq_size);
+    }
+  cq_ptr = nullptr;
+  if(sq_ptr)
+    {
+      munmap(sq_ptr, sq_size);
+      sq_ptr = nullptr;
+    }
+  if(ring_fd >= 0)
+    {
+      ::close(ring_fd);
+      ring_fd = -1;
+    }
+  // Engine falls back to Pread after ring has been closed, so memory of
+  // slots is released.
+  registered = false;
+  to_submit = 0;
+  buffers.reset();
+  std::vector<struct iovec>().swap(iovs);
+  std::vector<uint64_t>().swap(slot_offset);
+  std::vector<size_t>().swap(slot_length);
+}
+
+bool
+ReadEngine::readRing(const int &fd, std::string &result,
+                     const std::function<bool()> &canceled)
+{
+#ifdef HAVE_IO_URING
+  struct stat st;
+  if(fstat(fd, &st) != 0)
+    {
+      return false;
+    }
+  result.resize(static_cast<size_t>(st.st_size));
+
+  uint64_t next_offset = 0;
+  unsigned in_flight = 0;
+  to_submit = 0;
+  for(unsigned i = 0; i < queue_depth && next_offset < result.size(); i++)
+    {
+      slot_offset[i] = next_offset;
+      slot_length[i] = std::min(block_size, result.size() - next_offset);
+      next_offset += slot_length[i];
+      submit(fd, i);
+      in_flight++;
+    }
+
+  bool error = false;
+  bool stop = false;
+  while(in_flight > 0)
+    {
+      int ret = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd,
+                                         to_submit, 1,
+                                         IORING_ENTER_GETEVENTS, nullptr, 0));
+      if(ret < 0)
+        {
+          if(errno == EINTR)
+            {
+              continue;
+            }
+          // Ring is unusable, closing it cancels reads in flight.
+          std::cout << "ReadEngine::readRing error: " << std::strerror(errno)
+                    << std::endl;
+          closeRing();
+          type = Pread;
+          return false;
+        }
+      to_submit -= std::min(to_submit, static_cast<unsigned>(ret));
+      if(!stop && canceled())
+        {
+          stop = true;
+        }
+
+      unsigned head = *cq_head;
+      unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+      struct io_uring_cqe *cqe_arr = static_cast<struct io_uring_cqe *>(cqes);
+      while(head != tail)
+        {
+          struct io_uring_cqe &cqe = cqe_arr[head & *cq_mask];
+          head++;
+          unsigned slot = static_cast<unsigned>(cqe.user_data);
+          int res = cqe.res;
+          in_flight--;
+          if(res == -EINTR || res == -EAGAIN)
+            {
+              if(!stop && !error)
+                {
+                  submit(fd, slot);
+                  in_flight++;
+                }
+              continue;
+            }
+          if(res <= 0)
+            {
+              // Zero means that file has been truncated.
+              error = true;
+              continue;
+            }
+          if(error || stop)
+            {
+              continue;
+            }
+          std::memcpy(&result[slot_offset[slot]], iovs[slot].iov_base,
+                      static_cast<size_t>(res));
+          if(static_cast<size_t>(res) < slot_length[slot])
+            {
+              // Short read: the rest of block is requested again.
+              slot_offset[slot] += static_cast<uint64_t>(res);
+              slot_length[slot] -= static_cast<size_t>(res);
+            }
+          else if(next_offset < result.size())
+            {
+              slot_offset[slot] = next_offset;
+              slot_length[slot]
+                  = std::min(block_size, result.size() - next_offset);
+              next_offset += slot_length[slot];
+            }
+          else
+            {
+              continue;
+            }
+          submit(fd, slot);
+          in_flight++;
+        }
+      __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+    }
+
+  if(error)
+    {
+      std::cout << "ReadEngine::readRing error: cannot read file"
+                << std::endl;
+    }
+  return !error && !stop;
+#endif
+#ifndef HAVE_IO_URING
+  return false;
+#endif
+}
+
+void
+ReadEngine::submit(const int &fd, const unsigned &slot)
+{
+#ifdef HAVE_IO_URING
+  unsigned tail = *sq_tail;
+  unsigned idx = tail & *sq_mask;
+  struct io_uring_sqe *sqe = static_cast<struct io_uring_sqe *>(sqes) + idx;
+  std::memset(sqe, 0, sizeof(*sqe));
+  sqe->fd = fd;
+  sqe->off = slot_offset[slot];
+  sqe->user_data = slot;
+  if(registered)
+    {
+      sqe->opcode = IORING_OP_READ_FIXED;
+      sqe->addr = reinterpret_cast<uint64_t>(iovs[slot].iov_base);
+      sqe->len = static_cast<uint32_t>(slot_length[slot]);
+      sqe->buf_index = static_cast<uint16_t>(slot);
+    }
+  else
+    {
+      iovs[slot].iov_len = slot_length[slot];
+      sqe->opcode = IORING_OP_READV;
+      sqe->addr = reinterpret_cast<uint64_t>(&iovs[slot]);
+      sqe->len = 1;
+    }
+  sq_array[idx] = idx;
+  __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+  to_submit++;
+#endif
+}
+#endif
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <ReadEnginePool.h>
+#include <algorithm>
+
+ReadEnginePool::ReadEnginePool(const int &type, const unsigned &queue_depth,
+                               const uint64_t &memory_limit)
+{
+  this->type = type;
+  this->queue_depth = queue_depth;
+  this->memory_limit = memory_limit;
+}
+
+ReadEngineSlot *
+ReadEnginePool::acquire(const uint64_t &size)
+{
+  std::lock_guard<std::mutex> lglock(mtx);
+  // Free slot with the smallest sufficient buffer is taken, otherwise slot
+  // with the largest buffer, which is grown.
+  ReadEngineSlot *slot = nullptr;
+  for(auto it = slots.begin(); it != slots.end(); it++)
+    {
+      ReadEngineSlot *s = it->get();
+      if(s->busy)
+        {
+          continue;
+        }
+      uint64_t cap = s->buf.capacity();
+      if(!slot)
+        {
+          slot = s;
+          continue;
+        }
+      uint64_t slot_cap = slot->buf.capacity();
+      if(cap >= size ? slot_cap < size || cap < slot_cap : cap > slot_cap)
+        {
+          slot = s;
+        }
+    }
+
+  uint64_t need;
+  if(slot)
+    {
+      need = std::max(slot->reserved, slot->reserved - slot->buf.capacity()
+                                          + size);
+    }
+  else
+    {
+      // Memory of engine itself is known only after it has been created.
+      need = size;
+    }
+  uint64_t others = reserved - (slot ? slot->reserved : 0);
+  // Buffers of other free slots are given back, if memory is not enough.
+  for(auto it = slots.begin();
+      it != slots.end() && others + need > memory_limit; it++)
+    {
+      ReadEngineSlot *s = it->get();
+      if(s->busy || s == slot || s->buf.capacity() == 0)
+        {
+          continue;
+        }
+      uint64_t cap = s->buf.capacity();
+      std::string().swap(s->buf);
+      s->reserved -= std::min(s->reserved, cap);
+      reserved -= std::min(reserved, cap);
+      others -= std::min(others, cap);
+    }
+  if(others + need > memory_limit)
+    {
+      return nullptr;
+    }
+
+  if(!slot)
+    {
+      std::unique_ptr<ReadEngine> engine(new ReadEngine(type, queue_depth));
+      need += engine->memorySize();
+      if(others + need > memory_limit)
+        {
+          return nullptr;
+        }
+      slots.emplace_back(new ReadEngineSlot);
+      slot = slots.back().get();
+      slot->engine = std::move(engine);
+    }
+  reserved = others + need;
+  slot->reserved = need;
+  slot->busy = true;
+  if(slot->buf.capacity() < size)
+    {
+      // Growing string would take twice as much memory as needed.
+      std::string().swap(slot->buf);
+      slot->buf.reserve(size);
+    }
+  return slot;
+}
+
+void
+ReadEnginePool::release(ReadEngineSlot *slot)
+{
+  std::lock_guard<std::mutex> lglock(mtx);
+  // Buffer can be larger than requested, or engine can have switched to
+  // pread after error.
+  uint64_t actual = slot->buf.capacity() + slot->engine->memorySize();
+  reserved = reserved - slot->reserved + actual;
+  slot->reserved = actual;
+  slot->busy = false;
+}
@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <BookMeta.h>
+#include <SqliteExport.h>
+#include <algorithm>
+#include <iostream>
+
+SqliteExport::SqliteExport()
+{
+}
+
+#ifndef USE_SQLITE
+bool
+SqliteExport::write(const std::filesystem::path &,
+                    const std::filesystem::path &,
+                    const std::vector<FileParseEntry> &)
+{
+  std::cout << "SqliteExport::write error: plugin has been built without "
+               "SQLite support"
+            << std::endl;
+  return false;
+}
+#endif
+
+#ifdef USE_SQLITE
+bool
+SqliteExport::write(const std::filesystem::path &db_path,
+                    const std::filesystem::path &books_path,
+                    const std::vector<FileParseEntry> &base)
+{
+  // Database is written to temporary file first and then renamed, so
+  // readers never see partially written database.
+  std::filesystem::path tmp_path = db_path;
+  tmp_path += std::filesystem::u8path(".new");
+  std::error_code ec;
+  std::filesystem::remove(tmp_path, ec);
+
+  if(sqlite3_open_v2(tmp_path.u8string().c_str(), &db,
+                     SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr)
+     != SQLITE_OK)
+    {
+      std::cout << "SqliteExport::write error: " << sqlite3_errmsg(db)
+                << std::endl;
+      sqlite3_close(db);
+      db = nullptr;
+      return false;
+    }
+
+  // Database is new and is renamed only after successful load, so journal
+  // and syncs are not needed.
+  bool result = exec("PRAGMA page_size=65536;"
+                     "PRAGMA journal_mode=OFF;"
+                     "PRAGMA synchronous=OFF;"
+                     "PRAGMA locking_mode=EXCLUSIVE;"
+                     "PRAGMA temp_store=MEMORY;"
+                     "PRAGMA cache_size=-262144;"
+                     "CREATE TABLE collection(books_path TEXT NOT NULL);"
+                     "CREATE TABLE archives(id INTEGER PRIMARY KEY, "
+                     "path TEXT NOT NULL, hash TEXT NOT NULL);"
+                     "CREATE TABLE books(id INTEGER PRIMARY KEY, "
+                     "archive_id INTEGER NOT NULL, path TEXT NOT NULL, "
+                     "author TEXT, title TEXT, series TEXT, genre TEXT, "
+                     "date TEXT);"
+                     "BEGIN;");
+
+  sqlite3_stmt *coll_stmt = nullptr;
+  sqlite3_stmt *arch_stmt = nullptr;
+  sqlite3_stmt *batch_stmt = nullptr;
+  sqlite3_stmt *row_stmt = nullptr;
+  std::string books_path_str = books_path.u8string();
+  if(result)
+    {
+      result = sqlite3_prepare_v2(db,
+                                  "INSERT INTO collection VALUES (?);", -1,
+                                  &coll_stmt, nullptr)
+                   == SQLITE_OK
+               && sqlite3_prepare_v2(
+                      db, "INSERT INTO archives VALUES (?, ?, ?);", -1,
+                      &arch_stmt, nullptr)
+                      == SQLITE_OK
+               && prepareBooks(batch_rows, &batch_stmt)
+               && prepareBooks(1, &row_stmt);
+      if(!result)
+        {
+          std::cout << "SqliteExport::write error: " << sqlite3_errmsg(db)
+                    << std::endl;
+        }
+    }
+  if(result)
+    {
+      sqlite3_bind_text(coll_stmt, 1, books_path_str.c_str(),
+                        static_cast<int>(books_path_str.size()),
+                        SQLITE_STATIC);
+      result = step(coll_stmt);
+    }
+
+  // Books are inserted by batch_rows rows per statement execution, the
+  // rest of archive books are inserted one by one.
+  sqlite3_int64 book_id = 0;
+  size_t in_transaction = 0;
+  std::vector<std::string> series(batch_rows);
+  for(size_t i = 0; result && i < base.size(); i++)
+    {
+      const FileParseEntry &fpe = base[i];
+      sqlite3_int64 arch_id = static_cast<sqlite3_int64>(i + 1);
+      sqlite3_bind_int64(arch_stmt, 1, arch_id);
+      sqlite3_bind_text(arch_stmt, 2, fpe.file_rel_path.c_str(),
+                        static_cast<int>(fpe.file_rel_path.size()),
+                        SQLITE_STATIC);
+      sqlite3_bind_text(arch_stmt, 3, fpe.file_hash.c_str(),
+                        static_cast<int>(fpe.file_hash.size()),
+                        SQLITE_STATIC);
+      result = step(arch_stmt);
+
+      size_t n = 0;
+      while(result && n < fpe.books.size())
+        {
+          size_t rows = batch_rows;
+          sqlite3_stmt *stmt = batch_stmt;
+          if(fpe.books.size() - n < batch_rows)
+            {
+              rows = 1;
+              stmt = row_stmt;
+            }
+          int col = 1;
+          for(size_t j = n; j < n + rows; j++)
+            {
+              const BookParseEntry &bpe = fpe.books[j];
+              book_id++;
+              sqlite3_bind_int64(stmt, col++, book_id);
+              sqlite3_bind_int64(stmt, col++, arch_id);
+              // Series is written as it is written to base.
+              series[j - n] = bpe.book_series;
+              std::replace(series[j - n].begin(), series[j - n].end(),
+                           series_number_separator, ' ');
+              const std::string &ser = series[j - n];
+              for(const std::string *str :
+                  { &bpe.book_path, &bpe.book_author, &bpe.book_name, &ser,
+                    &bpe.book_genre, &bpe.book_date })
+                {
+                  sqlite3_bind_text(stmt, col++, str->c_str(),
+                                    static_cast<int>(str->size()),
+                                    SQLITE_STATIC);
+                }
+            }
+          result = step(stmt);
+          n += rows;
+          in_transaction += rows;
+        }
+
+      if(result && in_transaction >= transaction_rows)
+        {
+          result = exec("COMMIT;BEGIN;");
+          in_transaction = 0;
+        }
+    }
+
+  sqlite3_finalize(coll_stmt);
+  sqlite3_finalize(arch_stmt);
+  sqlite3_finalize(batch_stmt);
+  sqlite3_finalize(row_stmt);
+
+  // Indexes are built once after loading, which is much faster than
+  // updating them on every insert.
+  if(result)
+    {
+      result = exec("COMMIT;"
+                    "CREATE INDEX archives_path ON archives(path);"
+                    "CREATE INDEX books_archive ON books(archive_id);"
+                    "CREATE INDEX books_author ON books(author);"
+                    "CREATE INDEX books_title ON books(title);"
+                    "CREATE INDEX books_series ON books(series);"
+                    "CREATE INDEX books_genre ON books(genre);"
+                    "ANALYZE;");
+    }
+  sqlite3_close(db);
+  db = nullptr;
+
+  if(result)
+    {
+      std::filesystem::rename(tmp_path, db_path, ec);
+      if(ec)
+        {
+          std::cout << "SqliteExport::write error: " << ec.message()
+                    << std::endl;
+          result = false;
+        }
+    }
+  if(!result)
+    {
+      std::filesystem::remove(tmp_path, ec);
+    }
+  return result;
+}
+
+bool
+SqliteExport::exec(const std::string &sql)
+{
+  char *err = nullptr;
+  if(sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &err) != SQLITE_OK)
+    {
+      std::cout << "SqliteExport::exec error: " << (err ? err : "")
+                << std::endl;
+      sqlite3_free(err);
+      return false;
+    }
+  return true;
+}
+
+bool
+SqliteExport::prepareBooks(const size_t &rows, sqlite3_stmt **stmt)
+{
+  std::string sql = "INSERT INTO books VALUES ";
+  for(size_t i = 0; i < rows; i++)
+    {
+      if(i > 0)
+        {
+          sql += ",";
+        }
+      sql += "(?,?,?,?,?,?,?,?)";
+    }
+  sql += ";";
+  return sqlite3_prepare_v2(db, sql.c_str(), -1, stmt, nullptr) == SQLITE_OK;
+}
+
+bool
+SqliteExport::step(sqlite3_stmt *stmt)
+{
+  if(sqlite3_step(stmt) != SQLITE_DONE)
+    {
+      std::cout << "SqliteExport::step error: " << sqlite3_errmsg(db)
+                << std::endl;
+      sqlite3_reset(stmt);
+      return false;
+    }
+  sqlite3_reset(stmt);
+  return true;
+}
+#endif
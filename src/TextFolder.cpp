@@ -0,0 +1,272 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <TextFolder.h>
+
+TextFolder::TextFolder(const bool &transliterate)
+{
+  table.resize(0x530);
+  for(char32_t cp = 0; cp < table.size(); cp++)
+    {
+      table[cp] = toUtf8(cp);
+    }
+
+  for(char32_t cp = 0; cp < 0x80; cp++)
+    {
+      if(cp >= 'A' && cp <= 'Z')
+        {
+          set(cp, toUtf8(cp + 32));
+        }
+      else if(!(cp >= 'a' && cp <= 'z') && !(cp >= '0' && cp <= '9'))
+        {
+          set(cp, separator);
+        }
+    }
+
+  // Latin-1 Supplement: control characters and punctuation are separators,
+  // letters lose diacritics.
+  for(char32_t cp = 0x80; cp < 0xc0; cp++)
+    {
+      set(cp, separator);
+    }
+  set(0xaa, "a");
+  set(0xba, "o");
+  std::vector<std::string> latin1
+      = { "a",  "a", "a", "a", "a", "a", "ae", "c", "e", "e",  "e",
+          "e",  "i", "i", "i", "i", "d", "n",  "o", "o", "o",  "o",
+          "o",  " ", "o", "u", "u", "u", "u",  "y", "th", "ss" };
+  for(char32_t cp = 0xc0; cp < 0xe0; cp++)
+    {
+      set(cp, latin1[cp - 0xc0]);
+      set(cp + 0x20, latin1[cp - 0xc0]);
+    }
+  set(0xff, "y");
+
+  // Latin Extended-A. Capital and small letters alternate, "J" and "O" mark
+  // ligatures "ĳ" and "œ".
+  std::string latin_a = "aaaaaaccccccccddddeeeeeeeeeegggggggghhhhiiiiiiiiii"
+                        "JJjjkkkllllllllllnnnnnnnnnooooooOOrrrrrrssssssss"
+                        "ttttttuuuuuuuuuuuuwwyyyzzzzzzs";
+  for(char32_t cp = 0x100; cp < 0x180; cp++)
+    {
+      char ch = latin_a[cp - 0x100];
+      if(ch == 'J')
+        {
+          set(cp, "ij");
+        }
+      else if(ch == 'O')
+        {
+          set(cp, "oe");
+        }
+      else
+        {
+          set(cp, std::string(1, ch));
+        }
+    }
+
+  // Combining diacritical marks are removed.
+  for(char32_t cp = 0x300; cp < 0x370; cp++)
+    {
+      set(cp, std::string());
+    }
+
+  // Greek.
+  for(char32_t cp = 0x391; cp <= 0x3a9; cp++)
+    {
+      if(cp != 0x3a2)
+        {
+          set(cp, toUtf8(cp + 0x20));
+        }
+    }
+  set(0x386, toUtf8(0x3ac));
+  for(char32_t cp = 0x388; cp <= 0x38a; cp++)
+    {
+      set(cp, toUtf8(cp + 0x25));
+    }
+  set(0x38c, toUtf8(0x3cc));
+  set(0x38e, toUtf8(0x3cd));
+  set(0x38f, toUtf8(0x3ce));
+  set(0x3c2, toUtf8(0x3c3));
+
+  // Cyrillic. Letters of 0x460-0x52f range go in pairs: capital letter is
+  // followed by small one (0x4c1-0x4ce are shifted by one).
+  std::vector<char32_t> lower(table.size());
+  for(char32_t cp = 0; cp < lower.size(); cp++)
+    {
+      lower[cp] = cp;
+    }
+  for(char32_t cp = 0x400; cp < 0x410; cp++)
+    {
+      lower[cp] = cp + 0x50;
+    }
+  for(char32_t cp = 0x410; cp < 0x430; cp++)
+    {
+      lower[cp] = cp + 0x20;
+    }
+  for(char32_t cp = 0x460; cp < 0x530; cp += 2)
+    {
+      if(cp == 0x482)
+        {
+          cp = 0x48a;
+        }
+      if(cp == 0x4c0)
+        {
+          for(char32_t c = 0x4c1; c < 0x4cf; c += 2)
+            {
+              lower[c] = c + 1;
+            }
+          cp = 0x4d0;
+        }
+      lower[cp] = cp + 1;
+    }
+  lower[0x4c0] = 0x4cf;
+  lower[0x401] = 0x435;
+  lower[0x451] = 0x435;
+  for(char32_t cp = 0x400; cp < 0x530; cp++)
+    {
+      set(cp, toUtf8(lower[cp]));
+    }
+  for(char32_t cp = 0x483; cp < 0x48a; cp++)
+    {
+      set(cp, std::string());
+    }
+
+  if(transliterate)
+    {
+      std::vector<std::string> cyrillic
+          = { "a", "b",  "v",  "g",  "d",    "e", "zh", "z",
+              "i", "i",  "k",  "l",  "m",    "n", "o",  "p",
+              "r", "s",  "t",  "u",  "f",    "kh", "ts", "ch",
+              "sh", "shch", "", "y", "", "e", "iu", "ia" };
+      std::vector<std::string> cyrillic_ext
+          = { "e", "e", "dj", "g", "ie", "dz", "i",  "i",
+              "j", "lj", "nj", "c", "k", "i",  "u",  "dz" };
+      for(char32_t cp = 0x400; cp < 0x530; cp++)
+        {
+          char32_t l = lower[cp];
+          if(l >= 0x430 && l < 0x450)
+            {
+              set(cp, cyrillic[l - 0x430]);
+            }
+          else if(l >= 0x450 && l < 0x460)
+            {
+              set(cp, cyrillic_ext[l - 0x450]);
+            }
+          else if(l == 0x491)
+            {
+              set(cp, "g");
+            }
+        }
+    }
+}
+
+std::string
+TextFolder::fold(const std::string &str) const
+{
+  std::string result;
+  result.reserve(str.size());
+  bool space = false;
+  for(size_t i = 0; i < str.size();)
+    {
+      unsigned char ch = static_cast<unsigned char>(str[i]);
+      char32_t cp = ch;
+      size_t len = 1;
+      if(ch >= 0xc0 && ch < 0xf8)
+        {
+          len = ch < 0xe0 ? 2 : (ch < 0xf0 ? 3 : 4);
+          cp = ch & (0x7f >> len);
+          for(size_t j = 1; j < len; j++)
+            {
+              unsigned char c = i + j < str.size()
+                                    ? static_cast<unsigned char>(str[i + j])
+                                    : 0;
+              if((c & 0xc0) != 0x80)
+                {
+                  // Broken sequence, byte is copied as it is.
+                  len = 1;
+                  cp = 0x110000;
+                  break;
+                }
+              cp = (cp << 6) | (c & 0x3f);
+            }
+        }
+      else if(ch >= 0x80)
+        {
+          cp = 0x110000;
+        }
+
+      const std::string *val = nullptr;
+      if(cp < table.size())
+        {
+          val = &table[cp];
+        }
+      else if((cp >= 0x2000 && cp < 0x2070) || cp == 0x3000)
+        {
+          // General punctuation and ideographic space.
+          val = &separator;
+        }
+
+      if(val == &separator || (val && *val == separator))
+        {
+          space = !result.empty();
+        }
+      else if(!val || !val->empty())
+        {
+          if(space)
+            {
+              result.push_back(' ');
+              space = false;
+            }
+          if(val)
+            {
+              result += *val;
+            }
+          else
+            {
+              result.append(str, i, len);
+            }
+        }
+      i += len;
+    }
+  return result;
+}
+
+void
+TextFolder::set(const char32_t &cp, const std::string &val)
+{
+  table[cp] = val;
+}
+
+std::string
+TextFolder::toUtf8(const char32_t &cp)
+{
+  std::string result;
+  if(cp < 0x80)
+    {
+      result.push_back(static_cast<char>(cp));
+    }
+  else if(cp < 0x800)
+    {
+      result.push_back(static_cast<char>(0xc0 | (cp >> 6)));
+      result.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+    }
+  else
+    {
+      result.push_back(static_cast<char>(0xe0 | (cp >> 12)));
+      result.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+      result.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+    }
+  return result;
+}
@@ -0,0 +1,236 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <ThreadPriority.h>
+#include <iostream>
+
+#ifdef __linux
+#include <cerrno>
+#include <cstring>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Values from linux/ioprio.h, which is not always installed.
+#define ML_IOPRIO_WHO_PROCESS 1
+#define ML_IOPRIO_CLASS_SHIFT 13
+#define ML_IOPRIO_CLASS_BE 2
+#define ML_IOPRIO_CLASS_IDLE 3
+#endif
+
+ThreadPriority::ThreadPriority(const ImportOptions &options)
+{
+  priority = options.priority;
+#ifdef __linux
+  // All calls below change calling thread only: Linux treats thread id
+  // (or 0) as id of a separate schedulable entity.
+  pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+#ifdef USE_OPENMP
+  // OpenMP threads are reused by later parallel regions of the whole
+  // program, so CPU priority of them is lowered only if it can be raised
+  // back. I/O priority and affinity are restored always.
+  if(priority != ImportOptions::Normal && !restorable())
+    {
+      ioprio = static_cast<int>(
+          syscall(SYS_ioprio_get, ML_IOPRIO_WHO_PROCESS, 0));
+      int io_class = ML_IOPRIO_CLASS_IDLE << ML_IOPRIO_CLASS_SHIFT;
+      if(priority == ImportOptions::Low)
+        {
+          io_class = ML_IOPRIO_CLASS_BE << ML_IOPRIO_CLASS_SHIFT | 7;
+        }
+      syscall(SYS_ioprio_set, ML_IOPRIO_WHO_PROCESS, 0, io_class);
+      priority = ImportOptions::Normal;
+      io_only = true;
+    }
+#endif
+  switch(priority)
+    {
+    case ImportOptions::Low:
+      {
+        errno = 0;
+        nice = getpriority(PRIO_PROCESS, tid);
+        ioprio = static_cast<int>(
+            syscall(SYS_ioprio_get, ML_IOPRIO_WHO_PROCESS, 0));
+        if(setpriority(PRIO_PROCESS, tid, 10) != 0)
+          {
+            std::cout << "ThreadPriority::ThreadPriority setpriority: "
+                      << std::strerror(errno) << std::endl;
+          }
+        syscall(SYS_ioprio_set, ML_IOPRIO_WHO_PROCESS, 0,
+                ML_IOPRIO_CLASS_BE << ML_IOPRIO_CLASS_SHIFT | 7);
+        break;
+      }
+    case ImportOptions::Idle:
+      {
+        policy = sched_getscheduler(0);
+        sched_getparam(0, &param);
+        ioprio = static_cast<int>(
+            syscall(SYS_ioprio_get, ML_IOPRIO_WHO_PROCESS, 0));
+        sched_param idle_param;
+        idle_param.sched_priority = 0;
+        if(sched_setscheduler(0, SCHED_IDLE, &idle_param) != 0)
+          {
+            std::cout << "ThreadPriority::ThreadPriority sched_setscheduler: "
+                      << std::strerror(errno) << std::endl;
+          }
+        syscall(SYS_ioprio_set, ML_IOPRIO_WHO_PROCESS, 0,
+                ML_IOPRIO_CLASS_IDLE << ML_IOPRIO_CLASS_SHIFT);
+        break;
+      }
+    default:
+      break;
+    }
+
+  if(!options.cpus.empty()
+     && pthread_getaffinity_np(pthread_self(), sizeof(affinity), &affinity)
+            == 0)
+    {
+      cpu_set_t cpus;
+      CPU_ZERO(&cpus);
+      for(auto it = options.cpus.begin(); it != options.cpus.end(); it++)
+        {
+          if(*it >= 0 && *it < CPU_SETSIZE)
+            {
+              CPU_SET(*it, &cpus);
+            }
+        }
+      affinity_set
+          = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+    }
+#endif
+#ifdef _WIN32
+  HANDLE thr = GetCurrentThread();
+  switch(priority)
+    {
+    case ImportOptions::Low:
+      {
+        thr_priority = GetThreadPriority(thr);
+        SetThreadPriority(thr, THREAD_PRIORITY_LOWEST);
+        break;
+      }
+    case ImportOptions::Idle:
+      {
+        // Background mode lowers both CPU and I/O priorities.
+        SetThreadPriority(thr, THREAD_MODE_BACKGROUND_BEGIN);
+        break;
+      }
+    default:
+      break;
+    }
+
+  if(!options.cpus.empty())
+    {
+      DWORD_PTR mask = 0;
+      for(auto it = options.cpus.begin(); it != options.cpus.end(); it++)
+        {
+          if(*it >= 0 && *it < static_cast<int>(sizeof(mask) * 8))
+            {
+              mask |= static_cast<DWORD_PTR>(1) << *it;
+            }
+        }
+      affinity = SetThreadAffinityMask(thr, mask);
+      affinity_set = affinity != 0;
+    }
+#endif
+}
+
+ThreadPriority::~ThreadPriority()
+{
+#ifdef __linux
+  // Unprivileged thread may be unable to raise its priority back (see
+  // RLIMIT_NICE), so restoration is best effort.
+  pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+  switch(priority)
+    {
+    case ImportOptions::Low:
+      {
+        setpriority(PRIO_PROCESS, tid, nice);
+        syscall(SYS_ioprio_set, ML_IOPRIO_WHO_PROCESS, 0, ioprio);
+        break;
+      }
+    case ImportOptions::Idle:
+      {
+        sched_setscheduler(0, policy, &param);
+        syscall(SYS_ioprio_set, ML_IOPRIO_WHO_PROCESS, 0, ioprio);
+        break;
+      }
+    default:
+      {
+        if(io_only)
+          {
+            syscall(SYS_ioprio_set, ML_IOPRIO_WHO_PROCESS, 0, ioprio);
+          }
+        break;
+      }
+    }
+  if(affinity_set)
+    {
+      pthread_setaffinity_np(pthread_self(), sizeof(affinity), &affinity);
+    }
+#endif
+#ifdef _WIN32
+  HANDLE thr = GetCurrentThread();
+  switch(priority)
+    {
+    case ImportOptions::Low:
+      {
+        SetThreadPriority(thr, thr_priority);
+        break;
+      }
+    case ImportOptions::Idle:
+      {
+        SetThreadPriority(thr, THREAD_MODE_BACKGROUND_END);
+        break;
+      }
+    default:
+      break;
+    }
+  if(affinity_set)
+    {
+      SetThreadAffinityMask(thr, affinity);
+    }
+#endif
+}
+
+#ifdef __linux
+bool
+ThreadPriority::restorable()
+{
+  // Unprivileged thread can raise its nice value (or leave SCHED_IDLE
+  // policy) up to limit 20 - RLIMIT_NICE only.
+  if(geteuid() == 0)
+    {
+      return true;
+    }
+  errno = 0;
+  int cur_nice = getpriority(
+      PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)));
+  if(errno != 0)
+    {
+      return false;
+    }
+  rlimit lim;
+  if(getrlimit(RLIMIT_NICE, &lim) != 0)
+    {
+      return false;
+    }
+  if(lim.rlim_cur == RLIM_INFINITY)
+    {
+      return true;
+    }
+  return static_cast<rlim_t>(20 - cur_nice) <= lim.rlim_cur;
+}
+#endif
@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <TraceRecorder.h>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+
+TraceRecorder::TraceRecorder()
+{
+  // Recorder identifier is never reused, so thread buffers of destroyed
+  // recorder are not taken by new one placed at the same address.
+  static std::atomic<uint64_t> last_id(0);
+  id = last_id.fetch_add(1) + 1;
+  start = std::chrono::steady_clock::now();
+#ifdef USE_OPENMP
+  omp_init_lock(&buffers_mtx);
+#endif
+}
+
+TraceRecorder::~TraceRecorder()
+{
+#ifdef USE_OPENMP
+  omp_destroy_lock(&buffers_mtx);
+#endif
+}
+
+void
+TraceRecorder::begin(const char *name, const std::string &detail)
+{
+  TraceBuffer *buf = threadBuffer();
+  TraceEvent &ev = buf->events.emplace_back();
+  ev.name = name;
+  ev.phase = 'B';
+  ev.detail = detail;
+  ev.time = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start)
+                .count();
+}
+
+void
+TraceRecorder::end(const char *name)
+{
+  int64_t time = std::chrono::duration_cast<std::chrono::microseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  TraceBuffer *buf = threadBuffer();
+  TraceEvent &ev = buf->events.emplace_back();
+  ev.name = name;
+  ev.phase = 'E';
+  ev.time = time;
+}
+
+TraceBuffer *
+TraceRecorder::threadBuffer()
+{
+  // Several recorders can be used by the same thread at the same time (for
+  // example by imports of different collections), so buffers are looked up
+  // by recorder identifier.
+  thread_local std::unordered_map<uint64_t, TraceBuffer *> thread_buffers;
+  TraceBuffer *&buf = thread_buffers[id];
+  if(!buf)
+    {
+#ifndef USE_OPENMP
+      std::lock_guard<std::mutex> lglock(buffers_mtx);
+#endif
+#ifdef USE_OPENMP
+      omp_set_lock(&buffers_mtx);
+#endif
+      buffers.emplace_back(std::make_unique<TraceBuffer>());
+      buf = buffers.back().get();
+      buf->tid = static_cast<int>(buffers.size());
+      buf->events.reserve(1024);
+#ifdef USE_OPENMP
+      omp_unset_lock(&buffers_mtx);
+#endif
+    }
+  return buf;
+}
+
+bool
+TraceRecorder::write(const std::filesystem::path &trace_path)
+{
+  std::fstream f;
+  f.open(trace_path, std::ios_base::out | std::ios_base::binary);
+  if(!f.is_open())
+    {
+      std::cout << "TraceRecorder::write error: cannot open " << trace_path
+                << std::endl;
+      return false;
+    }
+
+  std::string buf = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  for(auto it = buffers.begin(); it != buffers.end(); it++)
+    {
+      std::string tid = std::to_string((*it)->tid);
+      if(!first)
+        {
+          buf += ",";
+        }
+      first = false;
+      buf += "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+             + tid + ",\"args\":{\"name\":\"thread " + tid + "\"}}";
+      for(auto it_e = (*it)->events.begin(); it_e != (*it)->events.end();
+          it_e++)
+        {
+          buf += ",\n{\"name\":\"";
+          buf += it_e->name;
+          buf += "\",\"ph\":\"";
+          buf.push_back(it_e->phase);
+          buf += "\",\"ts\":" + std::to_string(it_e->time)
+                 + ",\"pid\":1,\"tid\":" + tid;
+          if(!it_e->detail.empty())
+            {
+              buf += ",\"args\":{\"detail\":\"" + escape(it_e->detail)
+                     + "\"}";
+            }
+          buf += "}";
+          if(buf.size() > 1048576)
+            {
+              f.write(buf.c_str(), buf.size());
+              buf.clear();
+            }
+        }
+    }
+  buf += "\n]}\n";
+  f.write(buf.c_str(), buf.size());
+  bool result = f.good();
+  f.close();
+  if(!result || f.fail())
+    {
+      std::cout << "TraceRecorder::write error: cannot write " << trace_path
+                << std::endl;
+      return false;
+    }
+  return true;
+}
+
+std::string
+TraceRecorder::escape(const std::string &str)
+{
+  std::string result;
+  result.reserve(str.size());
+  for(auto it = str.begin(); it != str.end(); it++)
+    {
+      unsigned char ch = static_cast<unsigned char>(*it);
+      if(ch == '"' || ch == '\\')
+        {
+          result.push_back('\\');
+          result.push_back(*it);
+        }
+      else if(ch < 0x20)
+        {
+          char hex[7];
+          std::snprintf(hex, sizeof(hex), "\\u%04x", ch);
+          result += hex;
+        }
+      else
+        {
+          result.push_back(*it);
+        }
+    }
+  return result;
+}
+
+TraceScope::TraceScope(TraceRecorder *recorder, const char *name,
+                       const std::string &detail)
+{
+  this->recorder = recorder;
+  this->name = name;
+  if(recorder)
+    {
+      recorder->begin(name, detail);
+    }
+}
+
+TraceScope::~TraceScope()
+{
+  if(recorder)
+    {
+      recorder->end(name);
+    }
+}
@@ -0,0 +1,367 @@
+/*
+ * Copyright (C) 2025 Yury Bobylev <bobilev_yury@mail.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <ZipIndex.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <zlib.h>
+
+ZipIndex::ZipIndex()
+{
+}
+
+bool
+ZipIndex::readCentralDirectory(const std::filesystem::path &zip_path)
+{
+  names.clear();
+  legacy_names.clear();
+  stored.clear();
+  deflated.clear();
+
+  std::fstream f;
+  f.open(zip_path, std::ios_base::in | std::ios_base::binary);
+  if(!f.is_open())
+    {
+      std::cout << "ZipIndex::readCentralDirectory cannot open " << zip_path
+                << std::endl;
+      return false;
+    }
+
+  f.seekg(0, std::ios_base::end);
+  uint64_t fsz = static_cast<uint64_t>(f.tellg());
+
+  // End of central directory record is 22 bytes long plus up to 65535 bytes
+  // of comment.
+  const uint64_t eocd_sz = 22;
+  if(fsz < eocd_sz)
+    {
+      return false;
+    }
+  uint64_t tail_sz = eocd_sz + 65535 + 20;
+  if(tail_sz > fsz)
+    {
+      tail_sz = fsz;
+    }
+  std::string tail;
+  tail.resize(tail_sz);
+  f.seekg(fsz - tail_sz, std::ios_base::beg);
+  f.read(tail.data(), tail.size());
+  if(!f)
+    {
+      return false;
+    }
+
+  std::string::size_type eocd = std::string::npos;
+  for(std::string::size_type i = tail.size() - eocd_sz + 1; i > 0; i--)
+    {
+      if(get32(&tail[i - 1]) == 0x06054b50)
+        {
+          eocd = i - 1;
+          break;
+        }
+    }
+  if(eocd == std::string::npos)
+    {
+      return false;
+    }
+
+  uint64_t entries = get16(&tail[eocd + 10]);
+  uint64_t cd_size = get32(&tail[eocd + 12]);
+  uint64_t cd_offset = get32(&tail[eocd + 16]);
+
+  if(entries == 0xffff || cd_size == 0xffffffff || cd_offset == 0xffffffff)
+    {
+      // ZIP64 end of central directory locator precedes EOCD record.
+      if(eocd < 20 || get32(&tail[eocd - 20]) != 0x07064b50)
+        {
+          return false;
+        }
+      uint64_t z64_offset = get64(&tail[eocd - 12]);
+      if(z64_offset + 56 > fsz)
+        {
+          return false;
+        }
+      std::string z64;
+      z64.resize(56);
+      f.seekg(z64_offset, std::ios_base::beg);
+      f.read(z64.data(), z64.size());
+      if(!f || get32(&z64[0]) != 0x06064b50)
+        {
+          return false;
+        }
+      entries = get64(&z64[32]);
+      cd_size = get64(&z64[40]);
+      cd_offset = get64(&z64[48]);
+    }
+
+  if(cd_offset + cd_size > fsz)
+    {
+      return false;
+    }
+
+  std::string cd;
+  cd.resize(cd_size);
+  f.seekg(cd_offset, std::ios_base::beg);
+  f.read(cd.data(), cd.size());
+  if(!f)
+    {
+      return false;
+    }
+  f.close();
+
+  names.reserve(entries);
+  const std::string::size_type hdr_sz = 46;
+  std::string::size_type pos = 0;
+  for(uint64_t i = 0; i < entries; i++)
+    {
+      if(pos + hdr_sz > cd.size() || get32(&cd[pos]) != 0x02014b50)
+        {
+          names.clear();
+          legacy_names.clear();
+          stored.clear();
+          deflated.clear();
+          return false;
+        }
+      std::string::size_type name_len = get16(&cd[pos + 28]);
+      std::string::size_type extra_len = get16(&cd[pos + 30]);
+      std::string::size_type comment_len = get16(&cd[pos + 32]);
+      if(pos + hdr_sz + name_len > cd.size())
+        {
+          names.clear();
+          legacy_names.clear();
+          stored.clear();
+          deflated.clear();
+          return false;
+        }
+      std::string name(cd.begin() + pos + hdr_sz,
+                       cd.begin() + pos + hdr_sz + name_len);
+      // Entries with ZIP64 sizes or offsets are not recorded as stored or
+      // deflated, they are read by LibArchive.
+      uint16_t method = get16(&cd[pos + 10]);
+      uint64_t comp_sz = get32(&cd[pos + 20]);
+      uint64_t uncomp_sz = get32(&cd[pos + 24]);
+      uint64_t local_offset = get32(&cd[pos + 42]);
+      if(comp_sz != 0xffffffff && uncomp_sz != 0xffffffff
+         && local_offset != 0xffffffff)
+        {
+          if(method == 0 && comp_sz == uncomp_sz)
+            {
+              stored.emplace(name, std::make_pair(local_offset, comp_sz));
+            }
+          else if(method == 8)
+            {
+              deflated.emplace(name, std::make_tuple(local_offset, comp_sz,
+                                                     uncomp_sz));
+            }
+        }
+      uint16_t flags = get16(&cd[pos + 8]);
+      if(!(flags & 0x0800)
+         && std::any_of(name.begin(), name.end(), [](const char &el) {
+              return static_cast<unsigned char>(el) >= 0x80;
+            }))
+        {
+          legacy_names.insert(name);
+        }
+      names.emplace(std::move(name), get32(&cd[pos + 16]));
+      pos += hdr_sz + name_len + extra_len + comment_len;
+    }
+
+  return true;
+}
+
+bool
+ZipIndex::contains(const std::string &name) const
+{
+  return names.find(name) != names.end();
+}
+
+bool
+ZipIndex::uncheckable(const std::string &name) const
+{
+  return !legacy_names.empty()
+         && std::any_of(name.begin(), name.end(), [](const char &el) {
+              return static_cast<unsigned char>(el) >= 0x80;
+            });
+}
+
+bool
+ZipIndex::crc32(const std::string &name, uint32_t &crc) const
+{
+  auto it = names.find(name);
+  if(it == names.end())
+    {
+      return false;
+    }
+  crc = it->second;
+  return true;
+}
+
+bool
+ZipIndex::storedEntry(const std::string &name, uint64_t &offset,
+                      uint64_t &size) const
+{
+  auto it = stored.find(name);
+  if(it == stored.end())
+    {
+      return false;
+    }
+  offset = it->second.first;
+  size = it->second.second;
+  return true;
+}
+
+bool
+ZipIndex::storedData(const std::string_view &zip, const uint64_t &offset,
+                     const uint64_t &size, std::string_view &result)
+{
+  // Local file header is 30 bytes long plus file name and extra field.
+  const uint64_t hdr_sz = 30;
+  if(offset + hdr_sz > zip.size() || get32(&zip[offset]) != 0x04034b50)
+    {
+      return false;
+    }
+  uint64_t data_offset = offset + hdr_sz + get16(&zip[offset + 26])
+                         + get16(&zip[offset + 28]);
+  if(data_offset + size > zip.size())
+    {
+      return false;
+    }
+  result = zip.substr(data_offset, size);
+  return true;
+}
+
+bool
+ZipIndex::deflatedEntry(const std::string &name, uint64_t &offset,
+                        uint64_t &comp_size, uint64_t &size) const
+{
+  auto it = deflated.find(name);
+  if(it == deflated.end())
+    {
+      return false;
+    }
+  offset = std::get<0>(it->second);
+  comp_size = std::get<1>(it->second);
+  size = std::get<2>(it->second);
+  return true;
+}
+
+bool
+ZipIndex::inflatedData(const std::string_view &zip, const uint64_t &offset,
+                       const uint64_t &comp_size, const uint64_t &size,
+                       std::string &result)
+{
+  std::string_view comp;
+  if(!storedData(zip, offset, comp_size, comp))
+    {
+      return false;
+    }
+  result.resize(size);
+
+  // Raw deflate stream without zlib header.
+  z_stream strm;
+  std::memset(&strm, 0, sizeof(strm));
+  if(inflateInit2(&strm, -MAX_WBITS) != Z_OK)
+    {
+      result.clear();
+      return false;
+    }
+  strm.next_in
+      = reinterpret_cast<Bytef *>(const_cast<char *>(comp.data()));
+  strm.avail_in = static_cast<uInt>(comp.size());
+  strm.next_out = reinterpret_cast<Bytef *>(result.data());
+  strm.avail_out = static_cast<uInt>(result.size());
+  int ret = inflate(&strm, Z_FINISH);
+  bool complete = ret == Z_STREAM_END && strm.total_out == size;
+  inflateEnd(&strm);
+  if(!complete)
+    {
+      std::cout << "ZipIndex::inflatedData error: " << ret << std::endl;
+      result.clear();
+      return false;
+    }
+  return true;
+}
+
+bool
+ZipIndex::inflatedPrefix(const std::string_view &zip, const uint64_t &offset,
+                         const uint64_t &comp_size, const uint64_t &size,
+                         const std::string &marker, std::string &result)
+{
+  std::string_view comp;
+  if(!storedData(zip, offset, comp_size, comp))
+    {
+      return false;
+    }
+  result.clear();
+
+  z_stream strm;
+  std::memset(&strm, 0, sizeof(strm));
+  if(inflateInit2(&strm, -MAX_WBITS) != Z_OK)
+    {
+      return false;
+    }
+  strm.next_in
+      = reinterpret_cast<Bytef *>(const_cast<char *>(comp.data()));
+  strm.avail_in = static_cast<uInt>(comp.size());
+  // File is unpacked by blocks, every block is searched for marker
+  // together with end of previous one.
+  const uint64_t block = 65536;
+  int ret = Z_OK;
+  bool found = false;
+  while(ret == Z_OK && !found && result.size() < size)
+    {
+      size_t done = result.size();
+      size_t len = static_cast<size_t>(std::min(size - done, block));
+      result.resize(done + len);
+      strm.next_out = reinterpret_cast<Bytef *>(&result[done]);
+      strm.avail_out = static_cast<uInt>(len);
+      ret = inflate(&strm, Z_NO_FLUSH);
+      result.resize(done + len - strm.avail_out);
+      size_t from = done >= marker.size() ? done - marker.size() + 1 : 0;
+      found = result.find(marker, from) != std::string::npos;
+    }
+  inflateEnd(&strm);
+  if((ret != Z_OK && ret != Z_STREAM_END)
+     || (!found && result.size() != size))
+    {
+      std::cout << "ZipIndex::inflatedPrefix error: " << ret << std::endl;
+      result.clear();
+      return false;
+    }
+  return true;
+}
+
+uint16_t
+ZipIndex::get16(const char *buf)
+{
+  const unsigned char *b = reinterpret_cast<const unsigned char *>(buf);
+  return static_cast<uint16_t>(b[0]) | static_cast<uint16_t>(b[1]) << 8;
+}
+
+uint32_t
+ZipIndex::get32(const char *buf)
+{
+  return static_cast<uint32_t>(get16(buf))
+         | static_cast<uint32_t>(get16(buf + 2)) << 16;
+}
+
+uint64_t
+ZipIndex::get64(const char *buf)
+{
+  return static_cast<uint64_t>(get32(buf))
+         | static_cast<uint64_t>(get32(buf + 4)) << 32;
+}